@@ -0,0 +1,215 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <sycl/sycl.hpp>
+#include <type_traits>
+#include <vector>
+
+namespace syclalgo::detail {
+
+inline void depends_on(sycl::handler &cg,
+                       std::span<const sycl::event> dependences) {
+  static thread_local std::vector<sycl::event> kernel_dependences;
+  kernel_dependences.assign(dependences.begin(), dependences.end());
+  cg.depends_on(kernel_dependences);
+  kernel_dependences.clear();
+}
+
+constexpr auto ceil_div(size_t num, size_t denom) -> size_t {
+  return num / denom + (num % denom != 0);
+}
+
+constexpr auto align_up(size_t num, size_t alignment) -> size_t {
+  return ceil_div(num, alignment) * alignment;
+}
+
+// Lanes of the sycl::vec used for contiguous runs of T: 32 bytes of an
+// arithmetic type, at most 8 lanes. Other types are accessed one at a time.
+template <typename T>
+inline constexpr int VEC_WIDTH =
+    std::is_arithmetic_v<T> && !std::is_same_v<T, bool>
+        ? int(std::clamp<size_t>(32 / sizeof(T), 1, 8))
+        : 1;
+
+// Elements from p to the next address aligned to a whole vector of T.
+template <typename T> auto vec_head_elems(const T *p) -> size_t {
+  size_t pos = reinterpret_cast<uintptr_t>(p) / sizeof(T);
+  return (VEC_WIDTH<T> - pos % VEC_WIDTH<T>) % VEC_WIDTH<T>;
+}
+
+// Calls f with a zero of the narrowest unsigned type that counts up to n, so
+// that counts fit into packed partition descriptors unless n needs more than
+// 32 bits.
+template <typename F> auto with_count_type(size_t n, F f) {
+  if (n <= std::numeric_limits<uint32_t>::max()) {
+    return f(uint32_t());
+  }
+  return f(uint64_t());
+}
+
+enum class ScanAlgorithm {
+  Recursive,
+  Stream,
+  LookBack,
+  ReduceThenScan,
+  SingleGroup
+};
+
+auto scan_algorithm_name(ScanAlgorithm algorithm) -> std::string_view;
+
+enum class GroupScanAlgorithm { SubGroup, BrentKung };
+
+auto group_scan_algorithm_name(GroupScanAlgorithm algorithm)
+    -> std::string_view;
+
+// Tile shape of a scan kernel: work-items per work-group, elements per
+// work-item and the scan of the work-group.
+struct ScanConfig {
+  int block_size;
+  int elems;
+  GroupScanAlgorithm group_scan = GroupScanAlgorithm::SubGroup;
+
+  auto operator==(const ScanConfig &) const -> bool = default;
+};
+
+struct ScanChoice {
+  ScanAlgorithm algorithm;
+  ScanConfig config;
+};
+
+// The scan that syclalgo-tune measured fastest on a device for inputs of up
+// to max_n elements.
+struct ScanTuning {
+  std::string device_name;
+  std::string driver_version;
+  size_t max_n;
+  ScanChoice choice;
+};
+
+// The file named by SYCLALGO_TUNING_FILE, else
+// $HOME/.cache/syclalgo/scan-tuning.tsv, else none.
+auto scan_tuning_path() -> std::filesystem::path;
+
+// Tuning files hold one tab-separated line per tuning. Lines that do not parse
+// are skipped and a missing file holds no tunings.
+auto read_scan_tuning(const std::filesystem::path &path)
+    -> std::vector<ScanTuning>;
+
+void write_scan_tuning(const std::filesystem::path &path,
+                       std::span<const ScanTuning> tunings);
+
+// Device properties that the algorithms pick their variants and tile sizes
+// by, queried once per device.
+struct DeviceInfo {
+  sycl::info::device_type type;
+  size_t max_work_group_size;
+  size_t local_mem_size;
+  size_t global_mem_cache_size;
+  size_t max_compute_units;
+  // Tunings of the device from the tuning file, by increasing max_n.
+  std::vector<ScanTuning> scan_tunings;
+};
+
+auto get_device_info(const sycl::device &dev) -> const DeviceInfo &;
+
+// Whether work-groups that have started keep making progress while others wait
+// on them, which only GPU backends guarantee. Elsewhere the algorithms never
+// wait between work-groups.
+inline auto has_forward_progress(const DeviceInfo &info) -> bool {
+  return info.type == sycl::info::device_type::gpu;
+}
+
+// A kernel launch as take_kernel_records reports it.
+struct KernelLaunch {
+  std::string_view kernel;
+  size_t n;
+  size_t bytes;
+  int level = 0;
+};
+
+// Keep the event of a launch on a profiling queue for take_kernel_records.
+void record_kernel(sycl::queue &q, const KernelLaunch &launch, sycl::event e);
+
+// q.submit(cgf), recording the launch if the queue profiles its commands.
+template <typename CGF>
+auto submit_kernel(sycl::queue &q, const KernelLaunch &launch, CGF cgf)
+    -> sycl::event {
+  sycl::event e = q.submit(cgf);
+  if (q.has_property<sycl::property::queue::enable_profiling>()) {
+    record_kernel(q, launch, e);
+  }
+  return e;
+}
+
+struct Workspace {
+  void *ptr = nullptr;
+  // Work using the workspace must depend on this event.
+  sycl::event ready;
+};
+
+// Draw a workspace of `bytes` bytes from the queue's pool.
+auto allocate_workspace(sycl::queue &q, size_t bytes) -> Workspace;
+
+// Return a workspace to the queue's pool once `release` completes.
+void free_workspace(sycl::queue &q, void *ptr, sycl::event release);
+
+// Runs `algo(d_workspace, workspace_ready)` on a temporary workspace of
+// `bytes` bytes drawn from the queue's pool.
+template <typename F>
+auto with_temporary_workspace(sycl::queue &q, size_t bytes, F algo)
+    -> sycl::event {
+  Workspace workspace = allocate_workspace(q, bytes);
+  sycl::event e = algo(workspace.ptr, workspace.ready);
+  free_workspace(q, workspace.ptr, e);
+  return e;
+}
+
+// Layouts of the workspaces that algorithms reuse across calls without
+// clearing them. Calls only find a workspace as the previous call left it if
+// both lay it out alike.
+enum class WorkspaceLayout { StreamScan, LookBack, PackedLookBack, Reduce };
+
+// Calls on a reused workspace are numbered from 1 after it was last zeroed.
+// Zero stands for a workspace that the call has to clear itself.
+inline constexpr uint32_t MAX_WORKSPACE_EPOCH = (uint32_t(1) << 30) - 1;
+
+struct ReusedWorkspace {
+  void *ptr = nullptr;
+  // Work using the workspace must depend on this event.
+  sycl::event ready;
+  uint32_t epoch = 0;
+};
+
+// Take a workspace of at least `bytes` bytes that the queue keeps for calls
+// with `layout`. The call reads its first `tag_bytes` bytes as counters and
+// epoch-tagged words and may leave other data past them. The workspace is
+// zeroed when it is new or grows, when it was last used with another layout,
+// when its epochs run out and when earlier calls left data within the first
+// `tag_bytes` bytes.
+auto acquire_reused_workspace(sycl::queue &q, WorkspaceLayout layout,
+                              size_t bytes, size_t tag_bytes)
+    -> ReusedWorkspace;
+
+// Give a reused workspace back to the queue once `release` completes.
+void release_reused_workspace(sycl::queue &q, void *ptr, sycl::event release);
+
+// Runs `algo(d_workspace, workspace_ready, workspace_epoch)` on a workspace
+// reused across calls with `layout`.
+template <typename F>
+auto with_reused_workspace(sycl::queue &q, WorkspaceLayout layout,
+                           size_t bytes, size_t tag_bytes, F algo)
+    -> sycl::event {
+  ReusedWorkspace workspace =
+      acquire_reused_workspace(q, layout, bytes, tag_bytes);
+  sycl::event e = algo(workspace.ptr, workspace.ready, workspace.epoch);
+  release_reused_workspace(q, workspace.ptr, e);
+  return e;
+}
+
+} // namespace syclalgo::detail
@@ -0,0 +1,311 @@
+#pragma once
+#include "syclalgo-detail.hpp"
+#include "syclalgo.hpp"
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+namespace syclalgo::detail {
+
+inline constexpr int REDUCE_BLOCK_SIZE = 256;
+inline constexpr int REDUCE_ELEMS = 16;
+inline constexpr int REDUCE_MAX_GROUPS = 1024;
+
+inline auto reduce_num_groups(size_t n) -> size_t {
+  return std::min<size_t>(ceil_div(n, REDUCE_BLOCK_SIZE * REDUCE_ELEMS),
+                          REDUCE_MAX_GROUPS);
+}
+
+// The counter of finished work-groups comes first, where a reused workspace
+// has it whatever the input size and type.
+template <typename T> constexpr auto reduce_partials_offset() -> size_t {
+  return align_up(sizeof(int), alignof(T));
+}
+
+template <typename T> auto reduce_scratch_size(size_t n) -> size_t {
+  return reduce_partials_offset<T>() + sizeof(T) * reduce_num_groups(n);
+}
+
+// Tree reduction over a sub-group of any size, including a partial one.
+// sycl::reduce_over_group only takes the SYCL function objects, not the
+// operators of reduce and arg_reduce. Every work-item receives the result.
+template <typename T, typename BinaryOp>
+auto sub_group_reduce(sycl::sub_group sg, T x, BinaryOp op) -> T {
+  int sg_lid = sg.get_local_id();
+  int sg_size = sg.get_local_range()[0];
+  for (int offset = 1; offset < sg_size; offset *= 2) {
+    T y = sycl::shift_group_left(sg, x, offset);
+    if (sg_lid + offset < sg_size) {
+      x = op(x, y);
+    }
+  }
+  return sycl::group_broadcast(sg, x, 0);
+}
+
+// Reduces over the sub-groups and then over their results in local memory,
+// which holds one element per sub-group. The result is valid in the first
+// sub-group.
+template <typename T, typename BinaryOp>
+auto group_reduce(sycl::nd_item<1> id, sycl::local_ptr<T> shm, T x,
+                  BinaryOp op, T identity) -> T {
+  auto g = id.get_group();
+  auto sg = id.get_sub_group();
+  int sg_lid = sg.get_local_id();
+  int sg_size = sg.get_local_range()[0];
+  int sg_id = sg.get_group_linear_id();
+  int num_sgs = sg.get_group_linear_range();
+
+  x = sub_group_reduce(sg, x, op);
+  if (sg.leader()) {
+    shm[sg_id] = x;
+  }
+  sycl::group_barrier(g);
+
+  x = identity;
+  if (sg_id == 0) {
+    for (int i = sg_lid; i < num_sgs; i += sg_size) {
+      x = op(x, shm[i]);
+    }
+    x = sub_group_reduce(sg, x, op);
+  }
+  return x;
+}
+
+// Reduces load(0), ..., load(n - 1) and passes the result to store(value) in a
+// single launch. Every work-group reduces a strided share of the elements and
+// publishes it; the last group to finish reduces the published results and
+// zeroes the counter again, so that a reused workspace needs no clearing. A
+// workspace with epoch 0 has its counter cleared by a launch before.
+template <typename T, typename Load, typename Store, typename BinaryOp>
+auto reduce_impl(sycl::queue &q, size_t n, Load load, Store store, BinaryOp op,
+                 T identity, void *d_workspace,
+                 std::span<const sycl::event> dependences = {},
+                 sycl::event workspace_ready = {},
+                 uint32_t workspace_epoch = 0) -> sycl::event {
+  constexpr int BLOCK_SIZE = REDUCE_BLOCK_SIZE;
+
+  size_t num_groups = reduce_num_groups(n);
+  if (num_groups == 0) {
+    KernelLaunch launch = {"reduce empty", 0, sizeof(T)};
+    return submit_kernel(q, launch, [&](sycl::handler &cg) {
+      depends_on(cg, dependences);
+      cg.single_task([=] { store(identity); });
+    });
+  }
+
+  auto *d_num_finished = static_cast<int *>(d_workspace);
+  auto *d_partials = reinterpret_cast<T *>(
+      static_cast<std::byte *>(d_workspace) + reduce_partials_offset<T>());
+
+  sycl::event e = workspace_ready;
+  if (workspace_epoch == 0) {
+    KernelLaunch counter_reset = {"reduce counter reset", n, sizeof(int)};
+    e = submit_kernel(q, counter_reset, [&](sycl::handler &cg) {
+      depends_on(cg, dependences);
+      cg.depends_on(workspace_ready);
+      cg.memset(d_num_finished, 0, sizeof(int));
+    });
+  }
+
+  KernelLaunch reduce = {"reduce", n, sizeof(T) * (n + num_groups)};
+  return submit_kernel(q, reduce, [&](sycl::handler &cg) {
+    sycl::local_accessor<T> shm(BLOCK_SIZE, cg);
+    sycl::local_accessor<int> last_shm(1, cg);
+
+    cg.depends_on(e);
+    depends_on(cg, dependences);
+
+    sycl::nd_range<1> range = {num_groups * BLOCK_SIZE, BLOCK_SIZE};
+    cg.parallel_for(range, [=](sycl::nd_item<1> id) {
+      auto g = id.get_group();
+      size_t bid = g.get_group_id();
+
+      T r = identity;
+      for (size_t i = id.get_global_id(); i < n;
+           i += num_groups * BLOCK_SIZE) {
+        r = op(r, T(load(i)));
+      }
+      r = group_reduce<T>(id, shm, r, op, identity);
+
+      if (g.leader()) {
+        d_partials[bid] = r;
+        sycl::atomic_ref<int, sycl::memory_order_acq_rel,
+                         sycl::memory_scope::device,
+                         sycl::access::address_space::global_space>
+            num_finished_ref(*d_num_finished);
+        last_shm[0] = num_finished_ref.fetch_add(1) == int(num_groups) - 1;
+      }
+      sycl::group_barrier(g);
+
+      if (!last_shm[0]) {
+        return;
+      }
+      sycl::atomic_fence(sycl::memory_order_acquire,
+                         sycl::memory_scope::device);
+      if (g.leader()) {
+        *d_num_finished = 0;
+      }
+
+      r = identity;
+      for (size_t i = g.get_local_linear_id(); i < num_groups;
+           i += BLOCK_SIZE) {
+        r = op(r, d_partials[i]);
+      }
+      r = group_reduce<T>(id, shm, r, op, identity);
+      if (g.leader()) {
+        store(r);
+      }
+    });
+  });
+}
+
+template <typename T> struct ArgValue {
+  static constexpr size_t NO_INDEX = std::numeric_limits<size_t>::max();
+
+  T value;
+  size_t index;
+};
+
+// Picks the element that `comp` orders first and, of equivalent elements, the
+// one with the smaller index, so the operation is commutative.
+template <typename T, typename Compare> struct ArgSelect {
+  auto operator()(ArgValue<T> a, ArgValue<T> b) const -> ArgValue<T> {
+    if (b.index < a.index) {
+      std::swap(a, b);
+    }
+    if (b.index == ArgValue<T>::NO_INDEX) {
+      return a;
+    }
+    return Compare()(b.value, a.value) ? b : a;
+  }
+};
+
+template <typename T, typename Compare>
+auto arg_reduce(sycl::queue &q, size_t n, const T *d_data, size_t *d_index,
+                void *d_workspace,
+                std::span<const sycl::event> dependences = {},
+                sycl::event workspace_ready = {},
+                uint32_t workspace_epoch = 0) -> sycl::event {
+  auto load = [=](size_t i) { return ArgValue<T>{d_data[i], i}; };
+  auto store = [=](ArgValue<T> r) {
+    *d_index = r.index == ArgValue<T>::NO_INDEX ? n : r.index;
+  };
+  return reduce_impl(q, n, load, store, ArgSelect<T, Compare>(),
+                     ArgValue<T>{T(), ArgValue<T>::NO_INDEX}, d_workspace,
+                     dependences, workspace_ready, workspace_epoch);
+}
+
+// Runs `algo(d_workspace, workspace_ready, workspace_epoch)` on a reduction
+// workspace that the queue keeps across calls.
+template <typename T, typename F>
+auto with_reduce_workspace(sycl::queue &q, size_t n, F algo) -> sycl::event {
+  return with_reused_workspace(q, WorkspaceLayout::Reduce,
+                               reduce_scratch_size<T>(n), sizeof(int), algo);
+}
+
+} // namespace syclalgo::detail
+
+namespace syclalgo {
+
+template <typename T>
+auto reduce_workspace_size(sycl::queue &, size_t n) -> size_t {
+  return detail::reduce_scratch_size<T>(n);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto reduce(sycl::queue &q, size_t n, const InT *d_data, T *d_result,
+            BinaryOp op, std::type_identity_t<T> identity,
+            std::span<const sycl::event> dependences) -> sycl::event {
+  return transform_reduce(
+      q, n, d_data, d_result, op, identity, [](const InT &x) { return x; },
+      dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto reduce(sycl::queue &q, size_t n, const InT *d_data, T *d_result,
+            BinaryOp op, std::type_identity_t<T> identity, void *d_workspace,
+            std::span<const sycl::event> dependences) -> sycl::event {
+  return transform_reduce(
+      q, n, d_data, d_result, op, identity, [](const InT &x) { return x; },
+      d_workspace, dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp, typename UnaryOp>
+auto transform_reduce(sycl::queue &q, size_t n, const InT *d_data,
+                      T *d_result, BinaryOp op,
+                      std::type_identity_t<T> identity, UnaryOp transform,
+                      std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::with_reduce_workspace<T>(
+      q, n,
+      [&](void *d_workspace, sycl::event workspace_ready,
+          uint32_t workspace_epoch) {
+        auto load = [=](size_t i) { return transform(d_data[i]); };
+        auto store = [=](T r) { *d_result = r; };
+        return detail::reduce_impl(q, n, load, store, op, identity,
+                                   d_workspace, dependences, workspace_ready,
+                                   workspace_epoch);
+      });
+}
+
+template <typename InT, typename T, typename BinaryOp, typename UnaryOp>
+auto transform_reduce(sycl::queue &q, size_t n, const InT *d_data,
+                      T *d_result, BinaryOp op,
+                      std::type_identity_t<T> identity, UnaryOp transform,
+                      void *d_workspace,
+                      std::span<const sycl::event> dependences)
+    -> sycl::event {
+  auto load = [=](size_t i) { return transform(d_data[i]); };
+  auto store = [=](T r) { *d_result = r; };
+  return detail::reduce_impl(q, n, load, store, op, identity, d_workspace,
+                             dependences);
+}
+
+template <typename T>
+auto arg_reduce_workspace_size(sycl::queue &, size_t n) -> size_t {
+  return detail::reduce_scratch_size<detail::ArgValue<T>>(n);
+}
+
+template <typename T>
+auto argmin(sycl::queue &q, size_t n, const T *d_data, size_t *d_index,
+            std::span<const sycl::event> dependences) -> sycl::event {
+  return detail::with_reduce_workspace<detail::ArgValue<T>>(
+      q, n,
+      [&](void *d_workspace, sycl::event workspace_ready,
+          uint32_t workspace_epoch) {
+        return detail::arg_reduce<T, std::less<T>>(
+            q, n, d_data, d_index, d_workspace, dependences, workspace_ready,
+            workspace_epoch);
+      });
+}
+
+template <typename T>
+auto argmin(sycl::queue &q, size_t n, const T *d_data, size_t *d_index,
+            void *d_workspace, std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::arg_reduce<T, std::less<T>>(q, n, d_data, d_index,
+                                             d_workspace, dependences);
+}
+
+template <typename T>
+auto argmax(sycl::queue &q, size_t n, const T *d_data, size_t *d_index,
+            std::span<const sycl::event> dependences) -> sycl::event {
+  return detail::with_reduce_workspace<detail::ArgValue<T>>(
+      q, n,
+      [&](void *d_workspace, sycl::event workspace_ready,
+          uint32_t workspace_epoch) {
+        return detail::arg_reduce<T, std::greater<T>>(
+            q, n, d_data, d_index, d_workspace, dependences, workspace_ready,
+            workspace_epoch);
+      });
+}
+
+template <typename T>
+auto argmax(sycl::queue &q, size_t n, const T *d_data, size_t *d_index,
+            void *d_workspace, std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::arg_reduce<T, std::greater<T>>(q, n, d_data, d_index,
+                                                d_workspace, dependences);
+}
+
+} // namespace syclalgo
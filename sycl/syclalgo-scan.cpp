@@ -0,0 +1,248 @@
+// Prefix sums of a raw binary file of numbers into another, through
+// memory-mapped files that need not fit into host or device memory. The input
+// is scanned in windows of the mapping, each starting from the total of the
+// one before, while the kernel reads ahead the next window.
+//
+// Usage: syclalgo-scan [-i] [-t type] [-a type] [-w elements] input output
+//
+//   -i  inclusive scan instead of exclusive
+//   -t  element type of the input: int32 (default), int64 or float
+//   -a  element type of the output: the input type (default), or int64 for
+//       int32 input, or double for float input
+//   -w  elements per window, 2^26 by default
+#include "syclalgo.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t DEFAULT_WINDOW_ELEMS = size_t(1) << 26;
+
+struct Options {
+  bool inclusive = false;
+  std::string_view input_type = "int32";
+  std::string_view output_type;
+  size_t window_elems = DEFAULT_WINDOW_ELEMS;
+  const char *input_path = nullptr;
+  const char *output_path = nullptr;
+};
+
+// A file mapped into memory, unmapped when it goes out of scope.
+class MappedFile {
+public:
+  MappedFile() = default;
+  MappedFile(const MappedFile &) = delete;
+  auto operator=(const MappedFile &) -> MappedFile & = delete;
+  ~MappedFile() {
+    if (mapped) {
+      munmap(mapped, bytes);
+    }
+  }
+
+  // Maps the whole of an existing file for reading.
+  auto open_input(const char *path) -> bool {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && map(fd, st.st_size, PROT_READ);
+    close(fd);
+    return ok;
+  }
+
+  // Creates or truncates a file of `size` bytes and maps it for writing.
+  auto open_output(const char *path, size_t size) -> bool {
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      return false;
+    }
+    bool ok = ftruncate(fd, off_t(size)) == 0 &&
+              map(fd, size, PROT_READ | PROT_WRITE);
+    close(fd);
+    return ok;
+  }
+
+  // Asks the kernel to start reading bytes [offset, offset + length).
+  void will_need(size_t offset, size_t length) const {
+    if (mapped && offset < bytes) {
+      size_t begin = offset / page_size() * page_size();
+      size_t end = std::min(offset + length, bytes);
+      madvise(static_cast<std::byte *>(mapped) + begin, end - begin,
+              MADV_WILLNEED);
+    }
+  }
+
+  auto data() const -> void * { return mapped; }
+  auto size() const -> size_t { return bytes; }
+
+private:
+  static auto page_size() -> size_t { return size_t(sysconf(_SC_PAGESIZE)); }
+
+  // Empty files are valid but cannot be mapped.
+  auto map(int fd, size_t size, int prot) -> bool {
+    bytes = size;
+    if (size == 0) {
+      return true;
+    }
+    void *ptr = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+      return false;
+    }
+    mapped = ptr;
+    madvise(mapped, bytes, MADV_SEQUENTIAL);
+    return true;
+  }
+
+  void *mapped = nullptr;
+  size_t bytes = 0;
+};
+
+// Whether kernels on the queue's device read and write the mappings directly,
+// which saves copying them through device memory.
+auto scans_in_place(sycl::queue &q) -> bool {
+  sycl::device dev = q.get_device();
+  return dev.is_cpu() && dev.has(sycl::aspect::usm_system_allocations);
+}
+
+template <typename InT, typename T>
+auto scan_file(sycl::queue &q, const Options &options) -> int {
+  MappedFile input;
+  if (!input.open_input(options.input_path)) {
+    std::fprintf(stderr, "%s: %s\n", options.input_path, std::strerror(errno));
+    return EXIT_FAILURE;
+  }
+  if (input.size() % sizeof(InT) != 0) {
+    std::fprintf(stderr, "%s: size is not a multiple of %zu bytes\n",
+                 options.input_path, sizeof(InT));
+    return EXIT_FAILURE;
+  }
+  size_t n = input.size() / sizeof(InT);
+
+  MappedFile output;
+  if (!output.open_output(options.output_path, sizeof(T) * n)) {
+    std::fprintf(stderr, "%s: %s\n", options.output_path,
+                 std::strerror(errno));
+    return EXIT_FAILURE;
+  }
+
+  const auto *data = static_cast<const InT *>(input.data());
+  auto *out = static_cast<T *>(output.data());
+  size_t window_elems = options.window_elems;
+  bool in_place = scans_in_place(q);
+
+  // Totals of the last two windows, each window starting from the one before.
+  T *d_totals = sycl::malloc_device<T>(2, q);
+  if (!d_totals) {
+    std::fprintf(stderr, "out of device memory\n");
+    return EXIT_FAILURE;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  input.will_need(0, sizeof(InT) * window_elems);
+  for (size_t offset = 0, w = 0; offset < n; offset += window_elems, ++w) {
+    size_t count = std::min(window_elems, n - offset);
+    input.will_need(sizeof(InT) * (offset + window_elems),
+                    sizeof(InT) * window_elems);
+
+    syclalgo::ScanCarry<T> carry = {T(0), w > 0 ? d_totals + (w - 1) % 2
+                                                : nullptr,
+                                    d_totals + w % 2};
+    if (in_place && options.inclusive) {
+      syclalgo::inclusive_scan(q, count, data + offset, out + offset,
+                               sycl::plus<T>(), T(0), carry)
+          .wait();
+    } else if (in_place) {
+      syclalgo::exclusive_scan(q, count, data + offset, out + offset,
+                               sycl::plus<T>(), T(0), carry)
+          .wait();
+    } else if (options.inclusive) {
+      syclalgo::inclusive_host_scan(q, count, data + offset, out + offset,
+                                    sycl::plus<T>(), T(0), carry);
+    } else {
+      syclalgo::exclusive_host_scan(q, count, data + offset, out + offset,
+                                    sycl::plus<T>(), T(0), carry);
+    }
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  sycl::free(d_totals, q);
+
+  double bytes = double(input.size() + output.size());
+  std::printf("%zu elements in %.3f s, %.2f GB/s (%s)\n", n, elapsed.count(),
+              elapsed.count() > 0 ? bytes / elapsed.count() / 1e9 : 0.0,
+              in_place ? "in place" : "through device memory");
+  return EXIT_SUCCESS;
+}
+
+auto usage(const char *argv0) -> int {
+  std::fprintf(stderr,
+               "usage: %s [-i] [-t int32|int64|float] [-a int32|int64|float|"
+               "double] [-w elements] input output\n",
+               argv0);
+  return EXIT_FAILURE;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  int opt;
+  while ((opt = getopt(argc, argv, "it:a:w:")) != -1) {
+    switch (opt) {
+    case 'i':
+      options.inclusive = true;
+      break;
+    case 't':
+      options.input_type = optarg;
+      break;
+    case 'a':
+      options.output_type = optarg;
+      break;
+    case 'w':
+      options.window_elems = std::strtoull(optarg, nullptr, 10);
+      break;
+    default:
+      return usage(argv[0]);
+    }
+  }
+  if (argc - optind != 2 || options.window_elems == 0) {
+    return usage(argv[0]);
+  }
+  options.input_path = argv[optind];
+  options.output_path = argv[optind + 1];
+  if (options.output_type.empty()) {
+    options.output_type = options.input_type;
+  }
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::string_view in = options.input_type;
+  std::string_view out = options.output_type;
+  if (in == "int32" && out == "int32") {
+    return scan_file<int32_t, int32_t>(q, options);
+  }
+  if (in == "int32" && out == "int64") {
+    return scan_file<int32_t, int64_t>(q, options);
+  }
+  if (in == "int64" && out == "int64") {
+    return scan_file<int64_t, int64_t>(q, options);
+  }
+  if (in == "float" && out == "float") {
+    return scan_file<float, float>(q, options);
+  }
+  if (in == "float" && out == "double") {
+    return scan_file<float, double>(q, options);
+  }
+  return usage(argv[0]);
+}
@@ -0,0 +1,2770 @@
+#pragma once
+#include "syclalgo-detail.hpp"
+#include "syclalgo.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+namespace syclalgo::detail {
+
+enum class ScanType {
+  Exclusive,
+  Inclusive,
+};
+
+template <typename T> auto carry_in(const ScanCarry<T> &carry) -> T {
+  return carry.d_init ? *carry.d_init : carry.init;
+}
+
+// Input of a scan at position gidx. The carry-in is combined into position 0,
+// so that it reaches every result and every partial sum.
+template <ScanType ST, typename InT, typename T, typename BinaryOp>
+auto scan_input(const InT *d_data, size_t n, size_t gidx, BinaryOp op,
+                T identity, const ScanCarry<T> &carry) -> T {
+  if constexpr (ST == ScanType::Exclusive) {
+    if (gidx == 0) {
+      return carry_in(carry);
+    }
+    return gidx < n ? T(d_data[gidx - 1]) : identity;
+  } else if constexpr (ST == ScanType::Inclusive) {
+    if (gidx == 0) {
+      return op(carry_in(carry), T(d_data[0]));
+    }
+    return gidx < n ? T(d_data[gidx]) : identity;
+  }
+}
+
+// Called with the result s at every position gidx. The last position writes
+// the total of the scan if it is wanted.
+template <ScanType ST, typename InT, typename T, typename BinaryOp>
+void store_scan_total(const InT *d_data, size_t n, size_t gidx, T s,
+                      BinaryOp op, const ScanCarry<T> &carry) {
+  if (gidx + 1 != n || !carry.d_total) {
+    return;
+  }
+  if constexpr (ST == ScanType::Exclusive) {
+    *carry.d_total = op(s, T(d_data[gidx]));
+  } else if constexpr (ST == ScanType::Inclusive) {
+    *carry.d_total = s;
+  }
+}
+
+// Rows of local memory are padded to an odd length against bank conflicts.
+constexpr auto padded_row_elems(int elems) -> int {
+  return elems + (elems % 2 == 0);
+}
+
+inline constexpr int LOCAL_MEM_BANKS = 32;
+
+// Position of element i of a Brent-Kung scan in local memory. A padding slot
+// after every LOCAL_MEM_BANKS elements spreads the strided accesses of the
+// upper tree levels over the banks.
+constexpr auto brent_kung_index(int i) -> int {
+  return i + i / LOCAL_MEM_BANKS;
+}
+
+// Elements of local memory that group_inclusive_scan occupies: the elements,
+// followed by a slot for the total of each of up to block_size sub-groups.
+constexpr auto group_inclusive_scan_shm_size(int block_size, int elems = 1)
+    -> int {
+  return block_size * elems + block_size;
+}
+
+// Elements of local memory that a group scan of block_size * elems elements
+// occupies.
+constexpr auto group_scan_shm_size(GroupScanAlgorithm algorithm,
+                                   int block_size, int elems) -> int {
+  if (algorithm == GroupScanAlgorithm::BrentKung) {
+    return brent_kung_index(block_size * elems - 1) + 1;
+  }
+  return group_inclusive_scan_shm_size(block_size, elems);
+}
+
+template <typename T>
+constexpr auto scan_local_mem_size(ScanAlgorithm algorithm, ScanConfig config)
+    -> size_t {
+  switch (algorithm) {
+  case ScanAlgorithm::Recursive:
+  case ScanAlgorithm::SingleGroup:
+    return sizeof(T) * group_scan_shm_size(config.group_scan,
+                                           config.block_size, config.elems);
+  case ScanAlgorithm::Stream:
+    return sizeof(T) *
+               (config.block_size * padded_row_elems(config.elems) +
+                group_inclusive_scan_shm_size(config.block_size)) +
+           sizeof(int);
+  case ScanAlgorithm::LookBack:
+    return sizeof(T) * (config.block_size * padded_row_elems(config.elems) +
+                        group_scan_shm_size(config.group_scan,
+                                            config.block_size, 1)) +
+           sizeof(int);
+  case ScanAlgorithm::ReduceThenScan:
+    return sizeof(T) * group_inclusive_scan_shm_size(config.block_size);
+  }
+  return 0;
+}
+
+template <typename T>
+auto scan_fits(const sycl::device &dev, ScanAlgorithm algorithm,
+               ScanConfig config) -> bool {
+  const DeviceInfo &info = get_device_info(dev);
+  return size_t(config.block_size) <= info.max_work_group_size &&
+         scan_local_mem_size<T>(algorithm, config) <= info.local_mem_size;
+}
+
+// Calls f.template operator()<CONFIG>() with the entry of CONFIGS that equals
+// `config`, or with the first entry if none does. Every entry is instantiated.
+template <const auto &CONFIGS, size_t I = 0, typename F>
+auto with_scan_config(ScanConfig config, F f) {
+  if constexpr (I < std::size(CONFIGS)) {
+    if (config == CONFIGS[I]) {
+      return f.template operator()<CONFIGS[I]>();
+    }
+    return with_scan_config<CONFIGS, I + 1>(config, f);
+  } else {
+    return f.template operator()<CONFIGS[0]>();
+  }
+}
+
+// Inclusive scan over a sub-group. Ops without a native group scan take
+// log2(size) shifts, which keep the order of a non-commutative op.
+template <typename T, typename BinaryOp>
+auto sub_group_inclusive_scan(sycl::sub_group sg, T x, BinaryOp op) -> T {
+  if constexpr (sycl::has_known_identity_v<BinaryOp, T>) {
+    return sycl::inclusive_scan_over_group(sg, x, op);
+  } else {
+    int sg_lid = sg.get_local_id();
+    int sg_size = sg.get_local_range()[0];
+    for (int delta = 1; delta < sg_size; delta *= 2) {
+      T y = sycl::shift_group_right(sg, x, delta);
+      if (sg_lid >= delta) {
+        x = op(y, x);
+      }
+    }
+    return x;
+  }
+}
+
+// Inclusive scan of the BLOCK_SIZE * ELEMS elements in shm, which holds
+// group_inclusive_scan_shm_size(BLOCK_SIZE, ELEMS) elements. Every work-item
+// scans its ELEMS consecutive elements in registers and every sub-group the
+// totals of its work-items with shuffles. The sub-group totals are stored in
+// the slots after the elements, scanned there by the first sub-group, and each
+// work-item then reads the single prefix of its sub-group and writes its
+// elements back. Elements must be visible to their work-item on entry. The
+// third barrier only makes every element visible to the whole group on
+// return, which the callers read across work-items.
+template <int BLOCK_SIZE, int ELEMS, typename T, typename BinaryOp>
+void group_inclusive_scan(sycl::nd_item<1> id, sycl::local_ptr<T> shm,
+                          BinaryOp op) {
+  auto g = id.get_group();
+  auto sg = id.get_sub_group();
+  int lid = id.get_local_id();
+  int sg_lid = sg.get_local_id();
+  int sg_size = sg.get_local_range()[0];
+  int sg_id = sg.get_group_linear_id();
+  int num_sgs = sg.get_group_linear_range();
+  sycl::local_ptr<T> totals = shm + BLOCK_SIZE * ELEMS;
+
+  T x[ELEMS];
+  x[0] = shm[lid * ELEMS];
+  for (int i = 1; i < ELEMS; ++i) {
+    x[i] = op(x[i - 1], shm[lid * ELEMS + i]);
+  }
+
+  T sg_scan = sub_group_inclusive_scan(sg, x[ELEMS - 1], op);
+  T thread_prefix = sycl::shift_group_right(sg, sg_scan, 1);
+  if (sg_lid == sg_size - 1) {
+    totals[sg_id] = sg_scan;
+  }
+  sycl::group_barrier(g);
+
+  // Lanes past the last total repeat it; they come after every real total,
+  // so they do not change the scan of the others.
+  if (sg_id == 0) {
+    T carry;
+    for (int base = 0; base < num_sgs; base += sg_size) {
+      int j = base + sg_lid;
+      T t = sub_group_inclusive_scan(sg, totals[std::min(j, num_sgs - 1)], op);
+      if (base > 0) {
+        t = op(carry, t);
+      }
+      if (j < num_sgs) {
+        totals[j] = t;
+      }
+      carry = sycl::group_broadcast(sg, t, sg_size - 1);
+    }
+  }
+  sycl::group_barrier(g);
+
+  T prefix;
+  bool has_prefix = sg_id > 0;
+  if (has_prefix) {
+    prefix = totals[sg_id - 1];
+  }
+  if (sg_lid > 0) {
+    prefix = has_prefix ? op(prefix, thread_prefix) : thread_prefix;
+    has_prefix = true;
+  }
+
+  for (int i = 0; i < ELEMS; ++i) {
+    shm[lid * ELEMS + i] = has_prefix ? op(prefix, x[i]) : x[i];
+  }
+  sycl::group_barrier(g);
+}
+
+// Work-efficient inclusive scan of the BLOCK_SIZE * ELEMS elements at
+// brent_kung_index(i) in shm. The upsweep reduces blocks of doubling size in
+// place and the downsweep completes the prefixes from the largest blocks
+// down, with fewer than 2n applications of op and 2 log2(n) + 1 barriers. The
+// first barrier makes the elements, which are only visible to their own
+// work-item on entry, visible to the work-items that combine them in the
+// upsweep.
+template <int BLOCK_SIZE, int ELEMS, typename T, typename BinaryOp>
+void brent_kung_group_scan(sycl::nd_item<1> id, sycl::local_ptr<T> shm,
+                           BinaryOp op) {
+  constexpr int N = BLOCK_SIZE * ELEMS;
+
+  auto g = id.get_group();
+  int lid = id.get_local_id();
+  auto at = [=](int i) -> T & { return shm[brent_kung_index(i)]; };
+
+  sycl::group_barrier(g);
+  for (int stride = 1; stride < N; stride *= 2) {
+    for (int k = lid; (k + 1) * 2 * stride <= N; k += BLOCK_SIZE) {
+      int i = (k + 1) * 2 * stride - 1;
+      at(i) = op(at(i - stride), at(i));
+    }
+    sycl::group_barrier(g);
+  }
+
+  for (int stride = std::bit_floor(unsigned(N)) / 2; stride > 0; stride /= 2) {
+    for (int k = lid; (k + 1) * 2 * stride + stride <= N; k += BLOCK_SIZE) {
+      int i = (k + 1) * 2 * stride - 1;
+      at(i + stride) = op(at(i), at(i + stride));
+    }
+    sycl::group_barrier(g);
+  }
+}
+
+// Group scan policies of the scan kernels, picked by ScanConfig::group_scan.
+// Kernels keep element i of a group scan at index(i) of a local buffer of
+// group_scan_shm_size elements. Elements must be visible to their work-item
+// on entry; on return every element is visible to the whole group.
+struct SubGroupScan {
+  static constexpr auto index(int i) -> int { return i; }
+
+  template <int BLOCK_SIZE, int ELEMS, typename T, typename BinaryOp>
+  static void scan(sycl::nd_item<1> id, sycl::local_ptr<T> shm, BinaryOp op) {
+    group_inclusive_scan<BLOCK_SIZE, ELEMS, T>(id, shm, op);
+  }
+};
+
+struct BrentKungScan {
+  static constexpr auto index(int i) -> int { return brent_kung_index(i); }
+
+  template <int BLOCK_SIZE, int ELEMS, typename T, typename BinaryOp>
+  static void scan(sycl::nd_item<1> id, sycl::local_ptr<T> shm, BinaryOp op) {
+    brent_kung_group_scan<BLOCK_SIZE, ELEMS, T>(id, shm, op);
+  }
+};
+
+template <ScanConfig CONFIG>
+using GroupScan =
+    std::conditional_t<CONFIG.group_scan == GroupScanAlgorithm::BrentKung,
+                       BrentKungScan, SubGroupScan>;
+
+// Largest input for which a single work-group beats the multi-group scans.
+inline constexpr size_t SINGLE_GROUP_SCAN_MAX_N = size_t(1) << 14;
+
+// Tile shapes instantiated for tuning: a work-group for small inputs first and
+// one of about a sub-group of work-items for tiny inputs second.
+inline constexpr ScanConfig SINGLE_GROUP_SCAN_CONFIGS[] = {{256, 8}, {32, 8}};
+
+// Scans the input with one work-group, a tile at a time, carrying the total of
+// the tiles so far in registers. Takes a single launch and no workspace.
+template <ScanType ST, ScanConfig CONFIG = SINGLE_GROUP_SCAN_CONFIGS[0],
+          typename InT, typename T, typename BinaryOp>
+auto single_group_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                       BinaryOp op, T identity, ScanCarry<T> carry,
+                       std::span<const sycl::event> dependences = {})
+    -> sycl::event {
+  using GS = GroupScan<CONFIG>;
+  constexpr int BLOCK_SIZE = CONFIG.block_size;
+  constexpr int ELEMS = CONFIG.elems;
+  constexpr int BLOCK_ELEMS = BLOCK_SIZE * ELEMS;
+
+  if (n == 0) {
+    return {};
+  }
+
+  KernelLaunch launch = {"single-group scan", n,
+                         (sizeof(InT) + sizeof(T)) * n};
+  return submit_kernel(q, launch, [&](sycl::handler &cg) {
+    sycl::local_accessor<T> shm(
+        group_scan_shm_size(CONFIG.group_scan, BLOCK_SIZE, ELEMS), cg);
+
+    depends_on(cg, dependences);
+
+    sycl::nd_range<1> range = {BLOCK_SIZE, BLOCK_SIZE};
+    cg.parallel_for(range, [=](sycl::nd_item<1> id) {
+      auto g = id.get_group();
+      int lid = id.get_local_id();
+
+      T tiles_sum = identity;
+      for (size_t tile_offset = 0; tile_offset < n;
+           tile_offset += BLOCK_ELEMS) {
+        for (int i = 0; i < ELEMS; ++i) {
+          int lidx = i * BLOCK_SIZE + lid;
+          size_t gidx = tile_offset + lidx;
+          shm[GS::index(lidx)] =
+              scan_input<ST>(d_data, n, gidx, op, identity, carry);
+        }
+        sycl::group_barrier(g);
+
+        GS::template scan<BLOCK_SIZE, ELEMS, T>(id, shm, op);
+
+        for (int i = 0; i < ELEMS; ++i) {
+          int lidx = i * BLOCK_SIZE + lid;
+          size_t gidx = tile_offset + lidx;
+          if (gidx < n) {
+            T s = op(tiles_sum, shm[GS::index(lidx)]);
+            store_scan_total<ST>(d_data, n, gidx, s, op, carry);
+            d_out[gidx] = s;
+          }
+        }
+        tiles_sum = op(tiles_sum, shm[GS::index(BLOCK_ELEMS - 1)]);
+        sycl::group_barrier(g);
+      }
+    });
+  });
+}
+
+inline constexpr int RECURSIVE_SCAN_BLOCK_SIZE = 64;
+inline constexpr int RECURSIVE_SCAN_ELEMS = 8;
+
+// Tile shapes instantiated for tuning, the default first.
+inline constexpr ScanConfig RECURSIVE_SCAN_CONFIGS[] = {
+    {RECURSIVE_SCAN_BLOCK_SIZE, RECURSIVE_SCAN_ELEMS},
+    {128, 8},
+    {256, 4},
+    {128, 8, GroupScanAlgorithm::BrentKung}};
+
+template <typename T>
+auto recursive_scan_scratch_size(size_t n,
+                                 ScanConfig config = RECURSIVE_SCAN_CONFIGS[0])
+    -> size_t {
+  size_t block_elems = size_t(config.block_size) * config.elems;
+
+  size_t scratch_cnt = 0;
+  size_t num_groups = n;
+  while (num_groups > 1) {
+    num_groups = ceil_div(num_groups, block_elems);
+    scratch_cnt += num_groups;
+  }
+
+  return scratch_cnt > 1 ? sizeof(T) * scratch_cnt : 0;
+}
+
+template <ScanType ST, ScanConfig CONFIG, typename InT, typename T,
+          typename BinaryOp>
+auto recursive_scan_impl(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                         BinaryOp op, T identity, ScanCarry<T> carry,
+                         T *d_scratch,
+                         std::span<const sycl::event> dependences = {},
+                         sycl::event scratch_ready = {}, int level = 0)
+    -> sycl::event {
+  using GS = GroupScan<CONFIG>;
+  constexpr int BLOCK_SIZE = CONFIG.block_size;
+  constexpr int ELEMS = CONFIG.elems;
+  constexpr int BLOCK_ELEMS = BLOCK_SIZE * ELEMS;
+
+  size_t num_groups = ceil_div(n, BLOCK_ELEMS);
+  sycl::nd_range<1> range = {num_groups * BLOCK_SIZE, BLOCK_SIZE};
+
+  T *d_block_sum = num_groups > 1 ? d_scratch : nullptr;
+
+  size_t block_sum_bytes = d_block_sum ? sizeof(T) * num_groups : 0;
+  KernelLaunch upsweep = {"recursive upsweep", n,
+                          (sizeof(InT) + sizeof(T)) * n + block_sum_bytes,
+                          level};
+  sycl::event e = submit_kernel(q, upsweep, [&](sycl::handler &cg) {
+    sycl::local_accessor<T> shm(
+        group_scan_shm_size(CONFIG.group_scan, BLOCK_SIZE, ELEMS), cg);
+
+    depends_on(cg, dependences);
+    cg.depends_on(scratch_ready);
+
+    cg.parallel_for(range, [=](sycl::nd_item<1> id) {
+      auto g = id.get_group();
+      int lid = g.get_local_id();
+      size_t bid = g.get_group_id();
+
+      for (int i = 0; i < ELEMS; ++i) {
+        int lidx = i * BLOCK_SIZE + lid;
+        size_t gidx = bid * BLOCK_ELEMS + lidx;
+        shm[GS::index(lidx)] =
+            scan_input<ST>(d_data, n, gidx, op, identity, carry);
+      }
+      sycl::group_barrier(g);
+
+      GS::template scan<BLOCK_SIZE, ELEMS, T>(id, shm, op);
+
+      for (int i = 0; i < ELEMS; ++i) {
+        int lidx = i * BLOCK_SIZE + lid;
+        size_t gidx = bid * BLOCK_ELEMS + lidx;
+        if (gidx < n) {
+          T s = shm[GS::index(lidx)];
+          if (!d_block_sum) {
+            store_scan_total<ST>(d_data, n, gidx, s, op, carry);
+          }
+          d_out[gidx] = s;
+        }
+      }
+
+      if (d_block_sum && g.leader()) {
+        d_block_sum[bid] = shm[GS::index(BLOCK_ELEMS - 1)];
+      }
+    });
+  });
+
+  if (!d_block_sum) {
+    return e;
+  }
+
+  // The carry-in is already part of the block sums.
+  e = recursive_scan_impl<ScanType::Exclusive, CONFIG>(
+      q, num_groups, d_block_sum, d_block_sum, op, identity, {identity},
+      d_scratch + num_groups, {&e, 1}, {}, level + 1);
+
+  KernelLaunch downsweep = {"recursive downsweep", n,
+                            2 * sizeof(T) * n + block_sum_bytes, level};
+  return submit_kernel(q, downsweep, [&](sycl::handler &cg) {
+    cg.depends_on(e);
+    cg.parallel_for(range, [=](sycl::nd_item<1> id) {
+      auto g = id.get_group();
+      int lid = id.get_local_id();
+      size_t bid = g.get_group_id();
+      for (int i = 0; i < ELEMS; ++i) {
+        int lidx = i * BLOCK_SIZE + lid;
+        size_t gidx = bid * BLOCK_ELEMS + lidx;
+        if (gidx < n) {
+          T s = op(d_block_sum[bid], d_out[gidx]);
+          store_scan_total<ST>(d_data, n, gidx, s, op, carry);
+          d_out[gidx] = s;
+        }
+      }
+    });
+  });
+}
+
+template <ScanType ST, ScanConfig CONFIG = RECURSIVE_SCAN_CONFIGS[0],
+          typename InT, typename T, typename BinaryOp>
+auto recursive_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                    BinaryOp op, T identity, ScanCarry<T> carry,
+                    void *d_workspace,
+                    std::span<const sycl::event> dependences = {},
+                    sycl::event workspace_ready = {}) -> sycl::event {
+  if (n == 0) {
+    return {};
+  }
+
+  return recursive_scan_impl<ST, CONFIG>(
+      q, n, d_data, d_out, op, identity, carry,
+      static_cast<T *>(d_workspace), dependences, workspace_ready);
+}
+
+// Scans keep their counters at the start of the workspace, where a reused
+// workspace has them whatever the input size.
+template <typename T>
+constexpr auto scan_counters_size(int num_counters) -> size_t {
+  return align_up(sizeof(int) * num_counters,
+                  std::max(alignof(T), alignof(int64_t)));
+}
+
+#ifdef SYCLALGO_LOOK_BACK_STATS
+// In the order of the histograms of LookBackStats.
+enum class LookBackStat { StreamSpins, LookBackSpins, LookBackDepth };
+inline constexpr int NUM_LOOK_BACK_STATS = 3;
+
+inline constexpr int LOOK_BACK_BUCKETS =
+    std::tuple_size_v<decltype(LookBackHistogram::buckets)>;
+
+// The queue's histograms, one row of LOOK_BACK_BUCKETS counters per
+// LookBackStat.
+auto look_back_stats_buffer(sycl::queue &q) -> uint64_t *;
+
+// Waits of one work-group on its predecessors, added to the queue's histograms
+// once the work-group has its prefix.
+class LookBackCounts {
+public:
+  explicit LookBackCounts(sycl::queue &q)
+      : d_histograms(look_back_stats_buffer(q)) {}
+
+  // A poll found a predecessor that had not published its result yet.
+  void spin() { spins++; }
+
+  void walk(int num_predecessors) { predecessors += num_predecessors; }
+
+  void record_stream() const { add(LookBackStat::StreamSpins, spins); }
+
+  // Called by the whole sub-group that ran the look-back.
+  void record_look_back(sycl::sub_group sg) const {
+    uint64_t sg_spins =
+        sycl::reduce_over_group(sg, spins, sycl::plus<uint64_t>());
+    if (sg.leader()) {
+      add(LookBackStat::LookBackSpins, sg_spins);
+      add(LookBackStat::LookBackDepth, predecessors);
+    }
+  }
+
+private:
+  void add(LookBackStat stat, uint64_t count) const {
+    int bucket = std::min<int>(std::bit_width(count), LOOK_BACK_BUCKETS - 1);
+    sycl::atomic_ref<uint64_t, sycl::memory_order_relaxed,
+                     sycl::memory_scope::device,
+                     sycl::access::address_space::global_space>
+        bucket_ref(d_histograms[int(stat) * LOOK_BACK_BUCKETS + bucket]);
+    bucket_ref.fetch_add(1);
+  }
+
+  uint64_t *d_histograms;
+  uint64_t spins = 0;
+  uint64_t predecessors = 0;
+};
+#else
+// Counts nothing unless SYCLALGO_LOOK_BACK_STATS is defined.
+class LookBackCounts {
+public:
+  explicit LookBackCounts(sycl::queue &) {}
+  void spin() {}
+  void walk(int) {}
+  void record_stream() const {}
+  void record_look_back(sycl::sub_group) const {}
+};
+#endif
+
+inline constexpr int STREAM_SCAN_BLOCK_SIZE = 1024;
+inline constexpr int STREAM_SCAN_ELEMS = 7;
+inline constexpr int STREAM_SCAN_NUM_COUNTERS = 2;
+
+// Tile shapes instantiated for tuning, the default first and the fallback for
+// devices that do not fit the default second.
+inline constexpr ScanConfig STREAM_SCAN_CONFIGS[] = {
+    {STREAM_SCAN_BLOCK_SIZE, STREAM_SCAN_ELEMS}, {256, 7}, {256, 15}};
+
+template <typename T>
+auto stream_scan_config(const sycl::device &dev) -> ScanConfig {
+  if (scan_fits<T>(dev, ScanAlgorithm::Stream, STREAM_SCAN_CONFIGS[0])) {
+    return STREAM_SCAN_CONFIGS[0];
+  }
+  return STREAM_SCAN_CONFIGS[1];
+}
+
+template <typename T>
+auto stream_scan_scratch_size(ScanConfig config, size_t n) -> size_t {
+  size_t num_groups = ceil_div(n, size_t(config.block_size) * config.elems);
+  return scan_counters_size<T>(STREAM_SCAN_NUM_COUNTERS) +
+         sizeof(T) * (num_groups + 1);
+}
+
+template <ScanType ST, ScanConfig CONFIG, typename InT, typename T,
+          typename BinaryOp>
+auto stream_scan_impl(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                      BinaryOp op, T identity, ScanCarry<T> carry,
+                      void *d_workspace,
+                      std::span<const sycl::event> dependences,
+                      sycl::event workspace_ready,
+                      uint32_t workspace_epoch = 0) -> sycl::event {
+  constexpr int BLOCK_SIZE = CONFIG.block_size;
+  constexpr int ELEMS = CONFIG.elems;
+  constexpr int BLOCK_ELEMS = BLOCK_SIZE * ELEMS;
+  constexpr int COUNTER_NUM_STARTED = 0;
+  constexpr int COUNTER_NUM_FINISHED = 1;
+
+  size_t num_groups = ceil_div(n, BLOCK_ELEMS);
+
+  int *d_atomics = static_cast<int *>(d_workspace);
+  T *d_per_block_exc_sums = reinterpret_cast<T *>(
+      static_cast<std::byte *>(d_workspace) +
+      scan_counters_size<T>(STREAM_SCAN_NUM_COUNTERS));
+
+  // The last block leaves the counters zeroed, so a reused workspace is ready
+  // for the next call.
+  sycl::event e = workspace_ready;
+  if (workspace_epoch == 0) {
+    KernelLaunch counter_reset = {"stream counter reset", n, 2 * sizeof(int)};
+    e = submit_kernel(q, counter_reset, [&](sycl::handler &cg) {
+      depends_on(cg, dependences);
+      cg.depends_on(workspace_ready);
+      cg.single_task([=] {
+        d_atomics[COUNTER_NUM_STARTED] = 0;
+        d_atomics[COUNTER_NUM_FINISHED] = 0;
+      });
+    });
+  }
+
+  KernelLaunch scan_kernel = {"stream scan", n,
+                              (sizeof(InT) + sizeof(T)) * n +
+                                  2 * sizeof(T) * num_groups};
+  LookBackCounts look_back_counts(q);
+  e = submit_kernel(q, scan_kernel, [&](sycl::handler &cg) {
+    sycl::local_accessor<T, 2> shm({BLOCK_SIZE, padded_row_elems(ELEMS)}, cg);
+    sycl::local_accessor<T> scan_shm(
+        group_inclusive_scan_shm_size(BLOCK_SIZE), cg);
+    sycl::local_accessor<int> bid_shm(1, cg);
+
+    cg.depends_on(e);
+    depends_on(cg, dependences);
+
+    sycl::nd_range<1> range = {num_groups * BLOCK_SIZE, BLOCK_SIZE};
+    cg.parallel_for(range, [=](sycl::nd_item<1> id) {
+      auto g = id.get_group();
+      auto sg = id.get_sub_group();
+      int lid = id.get_local_id();
+      int sg_lid = sg.get_local_id();
+
+      if (lid == 0) {
+        sycl::atomic_ref<int, sycl::memory_order_relaxed,
+                         sycl::memory_scope::device,
+                         sycl::access::address_space::global_space>
+            num_started_ref(d_atomics[COUNTER_NUM_STARTED]);
+        int bid = num_started_ref.fetch_add(1);
+        if (bid == int(num_groups) - 1) {
+          num_started_ref.store(0);
+        }
+
+        bid_shm[0] = bid;
+      }
+      sycl::group_barrier(g);
+
+      int bid;
+      if (sg_lid == 0) {
+        bid = bid_shm[0];
+      }
+      sycl::group_barrier(sg);
+      bid = sycl::group_broadcast(sg, bid, 0);
+
+      size_t thread_offset = size_t(bid) * BLOCK_ELEMS + lid * ELEMS;
+
+      T r = identity;
+      for (int i = 0; i < ELEMS; ++i) {
+        size_t gidx = thread_offset + i;
+        T v = scan_input<ST>(d_data, n, gidx, op, identity, carry);
+        r = op(r, v);
+        shm[lid][i] = v;
+      }
+      scan_shm[lid] = r;
+
+      group_inclusive_scan<BLOCK_SIZE, 1, T>(id, scan_shm, op);
+
+      if (lid == 0) {
+        sycl::atomic_ref<int, sycl::memory_order_relaxed,
+                         sycl::memory_scope::device,
+                         sycl::access::address_space::global_space>
+            num_finished_ref(d_atomics[COUNTER_NUM_FINISHED]);
+
+        LookBackCounts counts = look_back_counts;
+        while (num_finished_ref.load(sycl::memory_order_acquire) != bid) {
+          counts.spin();
+        }
+        counts.record_stream();
+        T per_block_exc_sum = bid > 0 ? d_per_block_exc_sums[bid] : identity;
+
+        T block_sum = scan_shm[BLOCK_SIZE - 1];
+        d_per_block_exc_sums[bid + 1] = op(per_block_exc_sum, block_sum);
+        num_finished_ref.store(bid < int(num_groups) - 1 ? bid + 1 : 0,
+                               sycl::memory_order_release);
+
+        scan_shm[BLOCK_SIZE - 1] = per_block_exc_sum;
+      }
+      sycl::group_barrier(g);
+
+      T per_block_exc_sum;
+      if (sg_lid == 0) {
+        per_block_exc_sum = scan_shm[BLOCK_SIZE - 1];
+      }
+      sycl::group_barrier(sg);
+      per_block_exc_sum = sycl::group_broadcast(sg, per_block_exc_sum, 0);
+
+      T s = op(per_block_exc_sum, lid > 0 ? scan_shm[lid - 1] : identity);
+      for (int i = 0; i < ELEMS; ++i) {
+        s = op(s, shm[lid][i]);
+
+        size_t gidx = thread_offset + i;
+        if (gidx < n) {
+          store_scan_total<ST>(d_data, n, gidx, s, op, carry);
+          d_out[gidx] = s;
+        }
+      }
+    });
+  });
+
+  return e;
+}
+
+template <ScanType ST, typename InT, typename T, typename BinaryOp>
+auto stream_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                 BinaryOp op, T identity, ScanCarry<T> carry,
+                 void *d_workspace,
+                 std::span<const sycl::event> dependences = {},
+                 sycl::event workspace_ready = {},
+                 uint32_t workspace_epoch = 0) -> sycl::event {
+  if (stream_scan_config<T>(q.get_device()) == STREAM_SCAN_CONFIGS[0]) {
+    return stream_scan_impl<ST, STREAM_SCAN_CONFIGS[0]>(
+        q, n, d_data, d_out, op, identity, carry, d_workspace, dependences,
+        workspace_ready, workspace_epoch);
+  }
+  return stream_scan_impl<ST, STREAM_SCAN_CONFIGS[1]>(
+      q, n, d_data, d_out, op, identity, carry, d_workspace, dependences,
+      workspace_ready, workspace_epoch);
+}
+
+inline constexpr int REDUCE_THEN_SCAN_BLOCK_SIZE = 128;
+
+// Tile shapes instantiated for tuning, the default first. Zero elements per
+// work-item size the tile by the device cache.
+inline constexpr ScanConfig REDUCE_THEN_SCAN_CONFIGS[] = {
+    {REDUCE_THEN_SCAN_BLOCK_SIZE, 0}, {64, 0}, {128, 256}};
+
+// Reduce-then-scan tiles that each compute unit gets at least, so that all of
+// them are busy, unless a tile would hold fewer elements than work-items.
+inline constexpr size_t REDUCE_THEN_SCAN_TILES_PER_UNIT = 4;
+
+// Tiles are sized to stay in the device cache between the reduction and the
+// downsweep, which reads them again, but small enough to spread n over all
+// compute units.
+template <typename T>
+auto reduce_then_scan_tile_elems(
+    const sycl::device &dev, size_t n,
+    ScanConfig config = REDUCE_THEN_SCAN_CONFIGS[0]) -> size_t {
+  if (config.elems > 0) {
+    return size_t(config.block_size) * config.elems;
+  }
+  const DeviceInfo &info = get_device_info(dev);
+  size_t cache_elems =
+      info.global_mem_cache_size / 2 / config.block_size / sizeof(T);
+  size_t min_tiles = REDUCE_THEN_SCAN_TILES_PER_UNIT *
+                     std::max<size_t>(info.max_compute_units, 1);
+  size_t spread_elems = ceil_div(ceil_div(n, min_tiles), config.block_size);
+  return std::max<size_t>(std::min(cache_elems, spread_elems), 1) *
+         config.block_size;
+}
+
+template <typename T>
+auto reduce_then_scan_scratch_size(
+    const sycl::device &dev, size_t n,
+    ScanConfig config = REDUCE_THEN_SCAN_CONFIGS[0]) -> size_t {
+  size_t num_tiles =
+      ceil_div(n, reduce_then_scan_tile_elems<T>(dev, n, config));
+  return num_tiles > 1 ? sizeof(T) * num_tiles : 0;
+}
+
+// Calls f(gidx, x) in order with the scan input x of every position gidx in
+// [begin, end). Whole vectors are read from aligned input addresses, with
+// single elements before and after them. The input of an exclusive scan is
+// shifted by one position, so each vector contributes its lanes one position
+// later and its last lane is carried into the next vector.
+template <ScanType ST, typename InT, typename T, typename BinaryOp,
+          typename F>
+void for_each_scan_input(const InT *d_data, size_t n, size_t begin,
+                         size_t end, BinaryOp op, T identity,
+                         const ScanCarry<T> &carry, F f) {
+  constexpr int W = VEC_WIDTH<InT>;
+
+  auto load = [&](size_t gidx) {
+    return scan_input<ST>(d_data, n, gidx, op, identity, carry);
+  };
+
+  size_t i = begin;
+  if constexpr (W > 1) {
+    // Position 0 holds the carry-in, so it is never read as part of a vector.
+    size_t head = vec_head_elems(d_data + i);
+    if (i == 0 && head == 0) {
+      head = W;
+    }
+    size_t vec_begin = std::min(end, i + head);
+    for (; i < vec_begin; ++i) {
+      f(i, load(i));
+    }
+
+    // Positions i to i + W - 1 read the vector at i either way.
+    size_t vec_end = std::min(end, n);
+    T last = load(i);
+    for (; i + W <= vec_end; i += W) {
+      sycl::vec<InT, W> v;
+      v.load(0, sycl::address_space_cast<
+                    sycl::access::address_space::global_space,
+                    sycl::access::decorated::no>(d_data + i));
+      if constexpr (ST == ScanType::Exclusive) {
+        f(i, last);
+        for (int j = 0; j < W - 1; ++j) {
+          f(i + j + 1, T(v[j]));
+        }
+        last = T(v[W - 1]);
+      } else if constexpr (ST == ScanType::Inclusive) {
+        for (int j = 0; j < W; ++j) {
+          f(i + j, T(v[j]));
+        }
+      }
+    }
+  }
+  for (; i < end; ++i) {
+    f(i, load(i));
+  }
+}
+
+// Writes values to consecutive positions of d_out up to end, in order. Runs of
+// VEC_WIDTH<T> positions that start at an aligned output address are gathered
+// into a vector and stored at once, the others one at a time.
+template <typename T> class VecWriter {
+public:
+  VecWriter(T *d_out, size_t end) : d_out(d_out), end(end) {}
+
+  void operator()(size_t gidx, T x) {
+    if constexpr (W > 1) {
+      if (lanes == 0 && (gidx + W > end || vec_head_elems(d_out + gidx) != 0)) {
+        d_out[gidx] = x;
+        return;
+      }
+      v[lanes++] = x;
+      if (lanes == W) {
+        v.store(0, sycl::address_space_cast<
+                       sycl::access::address_space::global_space,
+                       sycl::access::decorated::no>(d_out + gidx + 1 - W));
+        lanes = 0;
+      }
+    } else {
+      d_out[gidx] = x;
+    }
+  }
+
+private:
+  static constexpr int W = VEC_WIDTH<T>;
+
+  T *d_out;
+  size_t end;
+  std::conditional_t<(W > 1), sycl::vec<T, W>, T> v = {};
+  int lanes = 0;
+};
+
+// Exclusive scans in place of the row_tiles tile sums of each of num_rows rows,
+// one work-group per row. Each work-item combines a contiguous run of tiles, so
+// that op is applied in order. total(row, value) receives the sum of every row.
+template <int BLOCK_SIZE, typename T, typename BinaryOp, typename Total>
+auto scan_tile_sums(sycl::queue &q, const KernelLaunch &launch,
+                    T *d_tile_sums, size_t num_rows, size_t row_tiles,
+                    BinaryOp op, T identity, Total total, sycl::event e)
+    -> sycl::event {
+  return submit_kernel(q, launch, [&](sycl::handler &cg) {
+    sycl::local_accessor<T> scan_shm(
+        group_inclusive_scan_shm_size(BLOCK_SIZE), cg);
+
+    cg.depends_on(e);
+
+    sycl::nd_range<1> range = {num_rows * BLOCK_SIZE, BLOCK_SIZE};
+    cg.parallel_for(range, [=](sycl::nd_item<1> id) {
+      auto g = id.get_group();
+      int lid = id.get_local_id();
+      size_t row = g.get_group_id();
+      T *d_row_sums = d_tile_sums + row * row_tiles;
+      size_t chunk = ceil_div(row_tiles, BLOCK_SIZE);
+      size_t begin = std::min(lid * chunk, row_tiles);
+      size_t end = std::min(begin + chunk, row_tiles);
+
+      T r = identity;
+      for (size_t i = begin; i < end; ++i) {
+        r = op(r, d_row_sums[i]);
+      }
+      scan_shm[lid] = r;
+
+      group_inclusive_scan<BLOCK_SIZE, 1, T>(id, scan_shm, op);
+
+      if (g.leader()) {
+        total(row, scan_shm[BLOCK_SIZE - 1]);
+      }
+      T prefix = lid > 0 ? scan_shm[lid - 1] : identity;
+      for (size_t i = begin; i < end; ++i) {
+        T sum = d_row_sums[i];
+        d_row_sums[i] = prefix;
+        prefix = op(prefix, sum);
+      }
+    });
+  });
+}
+
+// Scan without any waiting between work-groups, for devices that do not
+// guarantee forward progress to concurrently started work-groups. Every
+// work-group reduces one tile, a single work-group scans the tile sums, and
+// every tile is then scanned from its prefix. Each work-item handles a
+// contiguous run of its tile, so that op is applied in order.
+template <ScanType ST, ScanConfig CONFIG = REDUCE_THEN_SCAN_CONFIGS[0],
+          typename InT, typename T, typename BinaryOp>
+auto reduce_then_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                      BinaryOp op, T identity, ScanCarry<T> carry,
+                      void *d_workspace,
+                      std::span<const sycl::event> dependences = {},
+                      sycl::event workspace_ready = {}) -> sycl::event {
+  constexpr int BLOCK_SIZE = CONFIG.block_size;
+
+  if (n == 0) {
+    return {};
+  }
+
+  size_t tile_elems =
+      reduce_then_scan_tile_elems<T>(q.get_device(), n, CONFIG);
+  size_t thread_elems = tile_elems / BLOCK_SIZE;
+  size_t num_tiles = ceil_div(n, tile_elems);
+  sycl::nd_range<1> range = {num_tiles * BLOCK_SIZE, BLOCK_SIZE};
+
+  // Positions past n would only contribute the identity.
+  auto reduce_run = [=](size_t thread_offset) {
+    size_t end = std::min(thread_offset + thread_elems, n);
+    T r = identity;
+    for_each_scan_input<ST>(d_data, n, std::min(thread_offset, end), end, op,
+                            identity, carry,
+                            [&](size_t, T x) { r = op(r, x); });
+    return r;
+  };
+
+  T *d_tile_sums = num_tiles > 1 ? static_cast<T *>(d_workspace) : nullptr;
+  size_t tile_sum_bytes = d_tile_sums ? sizeof(T) * num_tiles : 0;
+
+  sycl::event e;
+  if (d_tile_sums) {
+    KernelLaunch reduce = {"reduce-then-scan reduce", n,
+                           sizeof(InT) * n + tile_sum_bytes};
+    e = submit_kernel(q, reduce, [&](sycl::handler &cg) {
+      sycl::local_accessor<T> scan_shm(
+          group_inclusive_scan_shm_size(BLOCK_SIZE), cg);
+
+      depends_on(cg, dependences);
+      cg.depends_on(workspace_ready);
+
+      cg.parallel_for(range, [=](sycl::nd_item<1> id) {
+        auto g = id.get_group();
+        int lid = id.get_local_id();
+        size_t tile = g.get_group_id();
+        size_t thread_offset = tile * tile_elems + lid * thread_elems;
+
+        scan_shm[lid] = reduce_run(thread_offset);
+
+        group_inclusive_scan<BLOCK_SIZE, 1, T>(id, scan_shm, op);
+
+        if (g.leader()) {
+          d_tile_sums[tile] = scan_shm[BLOCK_SIZE - 1];
+        }
+      });
+    });
+
+    KernelLaunch scan_tiles = {"reduce-then-scan tile sums", n,
+                               2 * tile_sum_bytes};
+    e = scan_tile_sums<BLOCK_SIZE>(q, scan_tiles, d_tile_sums, 1, num_tiles,
+                                   op, identity, [](size_t, T) {}, e);
+  }
+
+  KernelLaunch downsweep = {"reduce-then-scan downsweep", n,
+                            (sizeof(InT) + sizeof(T)) * n + tile_sum_bytes};
+  return submit_kernel(q, downsweep, [&](sycl::handler &cg) {
+    sycl::local_accessor<T> scan_shm(
+        group_inclusive_scan_shm_size(BLOCK_SIZE), cg);
+
+    cg.depends_on(e);
+    depends_on(cg, dependences);
+
+    cg.parallel_for(range, [=](sycl::nd_item<1> id) {
+      auto g = id.get_group();
+      int lid = id.get_local_id();
+      size_t tile = g.get_group_id();
+      size_t thread_offset = tile * tile_elems + lid * thread_elems;
+
+      scan_shm[lid] = reduce_run(thread_offset);
+
+      group_inclusive_scan<BLOCK_SIZE, 1, T>(id, scan_shm, op);
+
+      T s = d_tile_sums ? d_tile_sums[tile] : identity;
+      s = op(s, lid > 0 ? scan_shm[lid - 1] : identity);
+      size_t end = std::min(thread_offset + thread_elems, n);
+      VecWriter<T> write(d_out, end);
+      for_each_scan_input<ST>(d_data, n, std::min(thread_offset, end), end, op,
+                              identity, carry, [&](size_t gidx, T x) {
+                                s = op(s, x);
+                                store_scan_total<ST>(d_data, n, gidx, s, op,
+                                                     carry);
+                                write(gidx, s);
+                              });
+    });
+  });
+}
+
+inline constexpr int SPWDLB_SCAN_BLOCK_SIZE = 256;
+inline constexpr int SPWDLB_SCAN_ELEMS = 7;
+
+// Tile shapes instantiated for tuning, the default first.
+inline constexpr ScanConfig SPWDLB_SCAN_CONFIGS[] = {
+    {SPWDLB_SCAN_BLOCK_SIZE, SPWDLB_SCAN_ELEMS},
+    {128, 15},
+    {512, 7},
+    {SPWDLB_SCAN_BLOCK_SIZE, SPWDLB_SCAN_ELEMS, GroupScanAlgorithm::BrentKung}};
+
+enum PartitionStatus : int32_t {
+  Invalid = 0,
+  AggregateAvailable,
+  PrefixAvailable,
+};
+
+// Descriptors carry the epoch of the call that published them above their
+// status, so that descriptors left in a reused workspace by earlier calls read
+// as Invalid. Cleared descriptors have epoch 0, which no call uses.
+constexpr auto tag_status(PartitionStatus status, uint32_t epoch) -> int32_t {
+  return int32_t(epoch << 2 | status);
+}
+
+constexpr auto untag_status(int32_t tagged, uint32_t epoch) -> int32_t {
+  return uint32_t(tagged) >> 2 == epoch ? tagged & 3 : Invalid;
+}
+
+template <typename T> struct PartitionState {
+  int32_t status;
+  // Aggregate or inclusive prefix, depending on status.
+  T value;
+};
+
+// Values that fit into 32 bits are packed with their status into a single
+// 64-bit word, so that one relaxed atomic load observes a consistent pair.
+// Wider values are published through a separate status flag array.
+template <typename T>
+inline constexpr bool PACKED_PARTITION_DESCRIPTORS =
+    sizeof(T) <= sizeof(int32_t) && std::is_trivial_v<T>;
+
+template <typename T, bool PACKED = PACKED_PARTITION_DESCRIPTORS<T>>
+class PartitionDescriptors;
+
+template <typename T> class PartitionDescriptors<T, true> {
+public:
+  static auto storage_size(size_t num_partitions) -> size_t {
+    return sizeof(Descriptor) * num_partitions;
+  }
+
+  // Every descriptor keeps its status at the same place.
+  static auto tag_size(size_t num_partitions) -> size_t {
+    return storage_size(num_partitions);
+  }
+
+  PartitionDescriptors(void *d_storage, size_t, uint32_t epoch = 1)
+      : d_descriptors(static_cast<Descriptor *>(d_storage)), epoch(epoch) {}
+
+  void reset(size_t pid) const { d_descriptors[pid].status = Invalid; }
+
+  void store(size_t pid, PartitionStatus status, T value) const {
+    Descriptor desc;
+    desc.value = value;
+    desc.status = tag_status(status, epoch);
+    ref(pid).store(desc.word);
+  }
+
+  auto load(size_t pid) const -> PartitionState<T> {
+    Descriptor desc;
+    desc.word = ref(pid).load();
+    return {untag_status(desc.status, epoch), desc.value};
+  }
+
+private:
+  struct Descriptor {
+    union {
+      struct {
+        T value;
+        int32_t status;
+      };
+      int64_t word;
+    };
+  };
+  static_assert(sizeof(Descriptor) == sizeof(int64_t));
+
+  auto ref(size_t pid) const {
+    return sycl::atomic_ref<int64_t, sycl::memory_order_relaxed,
+                            sycl::memory_scope::device,
+                            sycl::access::address_space::global_space>(
+        d_descriptors[pid].word);
+  }
+
+  Descriptor *d_descriptors;
+  uint32_t epoch;
+};
+
+template <typename T> class PartitionDescriptors<T, false> {
+public:
+  static auto storage_size(size_t num_partitions) -> size_t {
+    return values_offset(num_partitions) + 2 * sizeof(T) * num_partitions;
+  }
+
+  // The values of fewer partitions or of other types overlap the statuses of
+  // more partitions.
+  static auto tag_size(size_t num_partitions) -> size_t {
+    return sizeof(int32_t) * num_partitions;
+  }
+
+  PartitionDescriptors(void *d_storage, size_t num_partitions,
+                       uint32_t epoch = 1)
+      : epoch(epoch) {
+    auto *d_bytes = static_cast<std::byte *>(d_storage);
+    d_status = reinterpret_cast<int32_t *>(d_bytes);
+    d_aggregates =
+        reinterpret_cast<T *>(d_bytes + values_offset(num_partitions));
+    d_inclusive_prefixes = d_aggregates + num_partitions;
+  }
+
+  void reset(size_t pid) const { d_status[pid] = Invalid; }
+
+  void store(size_t pid, PartitionStatus status, T value) const {
+    if (status == AggregateAvailable) {
+      d_aggregates[pid] = value;
+    } else {
+      d_inclusive_prefixes[pid] = value;
+    }
+    ref(pid).store(tag_status(status, epoch), sycl::memory_order_release);
+  }
+
+  auto load(size_t pid) const -> PartitionState<T> {
+    PartitionState<T> state{};
+    state.status =
+        untag_status(ref(pid).load(sycl::memory_order_acquire), epoch);
+    if (state.status == AggregateAvailable) {
+      state.value = d_aggregates[pid];
+    } else if (state.status == PrefixAvailable) {
+      state.value = d_inclusive_prefixes[pid];
+    }
+    return state;
+  }
+
+private:
+  static auto values_offset(size_t num_partitions) -> size_t {
+    return align_up(sizeof(int32_t) * num_partitions, alignof(T));
+  }
+
+  auto ref(size_t pid) const {
+    return sycl::atomic_ref<int32_t, sycl::memory_order_relaxed,
+                            sycl::memory_scope::device,
+                            sycl::access::address_space::global_space>(
+        d_status[pid]);
+  }
+
+  int32_t *d_status;
+  T *d_aggregates;
+  T *d_inclusive_prefixes;
+  uint32_t epoch;
+};
+
+inline auto spwdlb_scan_num_groups(size_t num_rows, size_t n,
+                                   ScanConfig config) -> size_t {
+  return num_rows * ceil_div(n, size_t(config.block_size) * config.elems);
+}
+
+template <typename T>
+auto spwdlb_scan_scratch_size(size_t n, size_t num_rows = 1,
+                              ScanConfig config = SPWDLB_SCAN_CONFIGS[0])
+    -> size_t {
+  return scan_counters_size<T>(1) +
+         PartitionDescriptors<T>::storage_size(
+             spwdlb_scan_num_groups(num_rows, n, config));
+}
+
+// Leading bytes of the workspace that hold the partition counter and the
+// statuses of the partitions.
+template <typename T>
+auto spwdlb_scan_tag_size(size_t n, size_t num_rows = 1,
+                          ScanConfig config = SPWDLB_SCAN_CONFIGS[0])
+    -> size_t {
+  return scan_counters_size<T>(1) +
+         PartitionDescriptors<T>::tag_size(
+             spwdlb_scan_num_groups(num_rows, n, config));
+}
+
+template <typename T>
+constexpr auto look_back_workspace_layout() -> WorkspaceLayout {
+  return PACKED_PARTITION_DESCRIPTORS<T> ? WorkspaceLayout::PackedLookBack
+                                         : WorkspaceLayout::LookBack;
+}
+
+// The look-back stops at the first accumulated prefix for which this holds.
+// It may only hold for values x with op(y, x) == x for all y.
+template <typename T> constexpr auto ends_look_back(const T &) -> bool {
+  return false;
+}
+
+template <typename T>
+auto reset_partitions(sycl::queue &q, size_t n,
+                      PartitionDescriptors<T> descriptors, int *d_bid,
+                      size_t num_groups,
+                      std::span<const sycl::event> dependences,
+                      sycl::event workspace_ready) -> sycl::event {
+  KernelLaunch launch = {
+      "look-back init", n,
+      sizeof(int) + PartitionDescriptors<T>::tag_size(num_groups)};
+  return submit_kernel(q, launch, [&](sycl::handler &cg) {
+    depends_on(cg, dependences);
+    cg.depends_on(workspace_ready);
+    cg.parallel_for(sycl::range(num_groups), [=](sycl::item<1> id) {
+      if (id == 0) {
+        *d_bid = 0;
+      }
+      descriptors.reset(id);
+    });
+  });
+}
+
+// Partition ids are handed out in the order in which work-groups start, so the
+// predecessors of a partition have all started before it. The last partition
+// zeroes the counter again for the next launch.
+inline auto next_partition(sycl::nd_item<1> id, int *d_bid,
+                           sycl::local_ptr<int> bid_shm, size_t num_partitions)
+    -> int {
+  auto g = id.get_group();
+  auto sg = id.get_sub_group();
+
+  if (g.leader()) {
+    sycl::atomic_ref<int, sycl::memory_order_relaxed,
+                     sycl::memory_scope::device,
+                     sycl::access::address_space::global_space>
+        bid_ref(*d_bid);
+    int bid = bid_ref.fetch_add(1);
+    if (bid == int(num_partitions) - 1) {
+      bid_ref.store(0);
+    }
+    bid_shm[0] = bid;
+  }
+  sycl::group_barrier(g);
+
+  int bid;
+  if (sg.leader()) {
+    bid = bid_shm[0];
+  }
+  sycl::group_barrier(sg);
+  return sycl::group_broadcast(sg, bid, 0);
+}
+
+// Publishes the aggregate of partition `bid` and returns the exclusive prefix
+// of the partition. Run by a single work-item; the first partition of a
+// look-back chain does not look back.
+template <typename T, typename BinaryOp>
+auto look_back(PartitionDescriptors<T> descriptors, size_t bid, bool first,
+               T aggregate, BinaryOp op, T identity) -> T {
+  // A partition whose aggregate ends the look-back has its inclusive prefix.
+  bool prefix_known = first || ends_look_back(aggregate);
+  descriptors.store(bid, prefix_known ? PrefixAvailable : AggregateAvailable,
+                    aggregate);
+
+  T exclusive_prefix = identity;
+  if (!first) {
+    for (size_t pid = bid - 1;; --pid) {
+      PartitionState<T> desc;
+      do {
+        desc = descriptors.load(pid);
+      } while (desc.status == Invalid);
+      exclusive_prefix = op(desc.value, exclusive_prefix);
+      if (desc.status == PrefixAvailable || ends_look_back(exclusive_prefix)) {
+        break;
+      }
+    }
+  }
+
+  if (!prefix_known) {
+    descriptors.store(bid, PrefixAvailable, op(exclusive_prefix, aggregate));
+  }
+  return exclusive_prefix;
+}
+
+// look_back run by a whole sub-group, which returns the exclusive prefix to
+// every work-item of it. Each step loads a window of one predecessor per
+// work-item, nearest first, waits until the ones up to the nearest inclusive
+// prefix are published and reduces them in order. The waits and
+// predecessors are added to `counts` if given.
+template <typename T, typename BinaryOp>
+auto sub_group_look_back(sycl::sub_group sg,
+                         PartitionDescriptors<T> descriptors, size_t bid,
+                         bool first, T aggregate, BinaryOp op, T identity,
+                         LookBackCounts *counts = nullptr) -> T {
+  int sg_lid = sg.get_local_id();
+  int sg_size = sg.get_max_local_range()[0];
+
+  bool prefix_known = first || ends_look_back(aggregate);
+  if (sg.leader()) {
+    descriptors.store(bid, prefix_known ? PrefixAvailable : AggregateAvailable,
+                      aggregate);
+  }
+
+  T exclusive_prefix = identity;
+  for (int64_t window = int64_t(bid) - 1; !first; window -= sg_size) {
+    // Chains start at a partition with a known prefix, so the look-back ends
+    // before the window passes the first partition.
+    int64_t pid = window - sg_lid;
+    // Partitions beyond the nearest published prefix are not needed, so only
+    // the ones before it are waited for.
+    PartitionState<T> desc = {pid >= 0 ? Invalid : PrefixAvailable, identity};
+    int stop = sg_size;
+    bool waiting;
+    do {
+      if (desc.status == Invalid && sg_lid < stop) {
+        desc = descriptors.load(pid);
+      }
+      stop = sycl::reduce_over_group(
+          sg, desc.status == PrefixAvailable ? sg_lid : sg_size,
+          sycl::minimum<int>());
+      waiting = desc.status == Invalid && sg_lid < stop;
+      if (counts && waiting) {
+        counts->spin();
+      }
+    } while (sycl::any_of_group(sg, waiting));
+    if (counts) {
+      counts->walk(std::min(stop + 1, sg_size));
+    }
+
+    // Nearer partitions are right operands, so the reduction keeps their
+    // order for non-commutative operators.
+    T x = sg_lid <= stop ? desc.value : identity;
+    for (int offset = 1; offset < sg_size; offset *= 2) {
+      T y = sycl::shift_group_left(sg, x, offset);
+      if (sg_lid + offset < sg_size) {
+        x = op(y, x);
+      }
+    }
+    exclusive_prefix = op(sycl::group_broadcast(sg, x, 0), exclusive_prefix);
+
+    if (stop < sg_size || ends_look_back(exclusive_prefix)) {
+      break;
+    }
+  }
+
+  if (!prefix_known && sg.leader()) {
+    descriptors.store(bid, PrefixAvailable, op(exclusive_prefix, aggregate));
+  }
+  return exclusive_prefix;
+}
+
+// Bytes that a row scan reads from its input and writes to its output per
+// position, for the kernel records.
+struct ElemBytes {
+  size_t in;
+  size_t out;
+};
+
+// Independent inclusive scans of the rows load(row, 0), ..., load(row, n - 1)
+// of a batch, passing every result to store(row, i, value). A work-item loads
+// increasing indices of one row from its own copy of `load`, which may
+// therefore keep a cursor.
+template <ScanConfig CONFIG = SPWDLB_SCAN_CONFIGS[0], typename T,
+          typename Load, typename Store, typename BinaryOp>
+auto spwdlb_scan_impl(sycl::queue &q, size_t num_rows, size_t n, Load load,
+                      Store store, BinaryOp op, T identity, void *d_workspace,
+                      std::span<const sycl::event> dependences = {},
+                      sycl::event workspace_ready = {},
+                      uint32_t workspace_epoch = 0,
+                      ElemBytes elem_bytes = {sizeof(T), sizeof(T)})
+    -> sycl::event {
+  using GS = GroupScan<CONFIG>;
+  constexpr int BLOCK_SIZE = CONFIG.block_size;
+  constexpr int ELEMS = CONFIG.elems;
+  constexpr int BLOCK_ELEMS = BLOCK_SIZE * ELEMS;
+  constexpr int LAST = GS::index(BLOCK_SIZE - 1);
+
+  // Partitions are numbered row by row, each row with its own look-back chain.
+  size_t row_groups = ceil_div(n, BLOCK_ELEMS);
+  size_t num_groups = num_rows * row_groups;
+  if (num_groups == 0) {
+    return {};
+  }
+
+  auto *d_bid = static_cast<int *>(d_workspace);
+  PartitionDescriptors<T> descriptors(
+      static_cast<std::byte *>(d_workspace) + scan_counters_size<T>(1),
+      num_groups, std::max<uint32_t>(workspace_epoch, 1));
+
+  // A reused workspace needs no clearing: the counter is zeroed by the last
+  // partition and descriptors of earlier calls have older epochs.
+  sycl::event e = workspace_ready;
+  if (workspace_epoch == 0) {
+    e = reset_partitions(q, num_rows * n, descriptors, d_bid, num_groups,
+                         dependences, workspace_ready);
+  }
+
+  KernelLaunch scan_kernel = {"look-back scan", num_rows * n,
+                              (elem_bytes.in + elem_bytes.out) * num_rows * n};
+  LookBackCounts look_back_counts(q);
+  e = submit_kernel(q, scan_kernel, [&](sycl::handler &cg) {
+    sycl::local_accessor<T, 2> shm({BLOCK_SIZE, padded_row_elems(ELEMS)}, cg);
+    sycl::local_accessor<T> scan_shm(
+        group_scan_shm_size(CONFIG.group_scan, BLOCK_SIZE, 1), cg);
+    sycl::local_accessor<int> bid_shm(1, cg);
+
+    cg.depends_on(e);
+    depends_on(cg, dependences);
+
+    sycl::nd_range<1> range = {num_groups * BLOCK_SIZE, BLOCK_SIZE};
+    cg.parallel_for(range, [=](sycl::nd_item<1> id) {
+      auto g = id.get_group();
+      auto sg = id.get_sub_group();
+      int lid = id.get_local_id();
+      int sg_lid = sg.get_local_id();
+
+      int bid = next_partition(id, d_bid, bid_shm, num_groups);
+
+      size_t row = bid / row_groups;
+      size_t row_bid = bid % row_groups;
+      size_t thread_offset = row_bid * BLOCK_ELEMS + lid * ELEMS;
+      Load thread_load = load;
+
+      T r = identity;
+      for (int i = 0; i < ELEMS; ++i) {
+        size_t gidx = thread_offset + i;
+        T v = gidx < n ? thread_load(row, gidx) : identity;
+        r = op(r, v);
+        shm[lid][i] = v;
+      }
+      scan_shm[GS::index(lid)] = r;
+
+      GS::template scan<BLOCK_SIZE, 1, T>(id, scan_shm, op);
+
+      if (sg.get_group_linear_id() == 0) {
+        // Each row starts its own look-back chain.
+        LookBackCounts counts = look_back_counts;
+        T prefix = sub_group_look_back(sg, descriptors, bid, row_bid == 0,
+                                       scan_shm[LAST], op, identity, &counts);
+        counts.record_look_back(sg);
+        sycl::group_barrier(sg);
+        if (sg.leader()) {
+          scan_shm[LAST] = prefix;
+        }
+      }
+
+      sycl::group_barrier(g);
+
+      T exclusive_prefix;
+      if (sg_lid == 0) {
+        exclusive_prefix = scan_shm[LAST];
+      }
+      sycl::group_barrier(sg);
+      exclusive_prefix = sycl::group_broadcast(sg, exclusive_prefix, 0);
+
+      T s = op(exclusive_prefix,
+               lid > 0 ? scan_shm[GS::index(lid - 1)] : identity);
+      for (int i = 0; i < ELEMS; ++i) {
+        s = op(s, shm[lid][i]);
+
+        size_t gidx = thread_offset + i;
+        if (gidx < n) {
+          store(row, gidx, s);
+        }
+      }
+    });
+  });
+
+  return e;
+}
+
+// The scans of spwdlb_scan_impl without any waiting between work-groups, for
+// devices that do not guarantee forward progress. Every work-group reduces one
+// tile of the same shape, the tile sums of every row are scanned, and every
+// tile is then scanned from its prefix. The tile sums take no more workspace
+// than the partition descriptors of spwdlb_scan_impl.
+template <ScanConfig CONFIG = SPWDLB_SCAN_CONFIGS[0], typename T,
+          typename Load, typename Store, typename BinaryOp>
+auto reduce_then_scan_rows(sycl::queue &q, size_t num_rows, size_t n,
+                           Load load, Store store, BinaryOp op, T identity,
+                           void *d_workspace,
+                           std::span<const sycl::event> dependences = {},
+                           sycl::event workspace_ready = {},
+                           ElemBytes elem_bytes = {sizeof(T), sizeof(T)})
+    -> sycl::event {
+  constexpr int BLOCK_SIZE = CONFIG.block_size;
+  constexpr int ELEMS = CONFIG.elems;
+  constexpr int BLOCK_ELEMS = BLOCK_SIZE * ELEMS;
+
+  size_t row_groups = ceil_div(n, BLOCK_ELEMS);
+  size_t num_groups = num_rows * row_groups;
+  if (num_groups == 0) {
+    return {};
+  }
+  sycl::nd_range<1> range = {num_groups * BLOCK_SIZE, BLOCK_SIZE};
+
+  // Positions past n would only contribute the identity.
+  auto reduce_run = [=](size_t row, size_t thread_offset) {
+    Load thread_load = load;
+    T r = identity;
+    for (int i = 0; i < ELEMS && thread_offset + i < n; ++i) {
+      r = op(r, thread_load(row, thread_offset + i));
+    }
+    return r;
+  };
+
+  // Rows of a single tile start from the identity.
+  T *d_tile_sums = row_groups > 1 ? static_cast<T *>(d_workspace) : nullptr;
+  size_t tile_sum_bytes = d_tile_sums ? sizeof(T) * num_groups : 0;
+
+  sycl::event e;
+  if (d_tile_sums) {
+    KernelLaunch reduce = {"reduce-then-scan reduce", num_rows * n,
+                           elem_bytes.in * num_rows * n + tile_sum_bytes};
+    e = submit_kernel(q, reduce, [&](sycl::handler &cg) {
+      sycl::local_accessor<T> scan_shm(
+          group_inclusive_scan_shm_size(BLOCK_SIZE), cg);
+
+      depends_on(cg, dependences);
+      cg.depends_on(workspace_ready);
+
+      cg.parallel_for(range, [=](sycl::nd_item<1> id) {
+        auto g = id.get_group();
+        int lid = id.get_local_id();
+        size_t bid = g.get_group_id();
+        size_t row = bid / row_groups;
+        size_t thread_offset = bid % row_groups * BLOCK_ELEMS + lid * ELEMS;
+
+        scan_shm[lid] = reduce_run(row, thread_offset);
+
+        group_inclusive_scan<BLOCK_SIZE, 1, T>(id, scan_shm, op);
+
+        if (g.leader()) {
+          d_tile_sums[bid] = scan_shm[BLOCK_SIZE - 1];
+        }
+      });
+    });
+
+    KernelLaunch scan_tiles = {"reduce-then-scan tile sums", num_rows * n,
+                               2 * tile_sum_bytes};
+    e = scan_tile_sums<BLOCK_SIZE>(q, scan_tiles, d_tile_sums, num_rows,
+                                   row_groups, op, identity,
+                                   [](size_t, T) {}, e);
+  }
+
+  KernelLaunch downsweep = {"reduce-then-scan downsweep", num_rows * n,
+                            (elem_bytes.in + elem_bytes.out) * num_rows * n +
+                                tile_sum_bytes};
+  return submit_kernel(q, downsweep, [&](sycl::handler &cg) {
+    sycl::local_accessor<T> scan_shm(
+        group_inclusive_scan_shm_size(BLOCK_SIZE), cg);
+
+    cg.depends_on(e);
+    depends_on(cg, dependences);
+
+    cg.parallel_for(range, [=](sycl::nd_item<1> id) {
+      auto g = id.get_group();
+      int lid = id.get_local_id();
+      size_t bid = g.get_group_id();
+      size_t row = bid / row_groups;
+      size_t thread_offset = bid % row_groups * BLOCK_ELEMS + lid * ELEMS;
+
+      scan_shm[lid] = reduce_run(row, thread_offset);
+
+      group_inclusive_scan<BLOCK_SIZE, 1, T>(id, scan_shm, op);
+
+      T s = d_tile_sums ? d_tile_sums[bid] : identity;
+      s = op(s, lid > 0 ? scan_shm[lid - 1] : identity);
+      Load thread_load = load;
+      for (int i = 0; i < ELEMS && thread_offset + i < n; ++i) {
+        size_t gidx = thread_offset + i;
+        s = op(s, thread_load(row, gidx));
+        store(row, gidx, s);
+      }
+    });
+  });
+}
+
+// spwdlb_scan_impl on devices that guarantee forward progress and
+// reduce_then_scan_rows on the others, in the same workspace.
+template <ScanConfig CONFIG = SPWDLB_SCAN_CONFIGS[0], typename T,
+          typename Load, typename Store, typename BinaryOp>
+auto rows_scan_impl(sycl::queue &q, size_t num_rows, size_t n, Load load,
+                    Store store, BinaryOp op, T identity, void *d_workspace,
+                    std::span<const sycl::event> dependences = {},
+                    sycl::event workspace_ready = {},
+                    uint32_t workspace_epoch = 0,
+                    ElemBytes elem_bytes = {sizeof(T), sizeof(T)})
+    -> sycl::event {
+  if (!has_forward_progress(get_device_info(q.get_device()))) {
+    return reduce_then_scan_rows<CONFIG>(q, num_rows, n, load, store, op,
+                                         identity, d_workspace, dependences,
+                                         workspace_ready, elem_bytes);
+  }
+  return spwdlb_scan_impl<CONFIG>(q, num_rows, n, load, store, op, identity,
+                                  d_workspace, dependences, workspace_ready,
+                                  workspace_epoch, elem_bytes);
+}
+
+// Row r of a batch starts at d_data + r * stride.
+template <typename P> struct StridedRows {
+  P *d_data;
+  size_t stride;
+
+  auto operator()(size_t row) const -> P * { return d_data + row * stride; }
+};
+
+// Row r of a batch starts at d_rows[r].
+template <typename P> struct IndirectRows {
+  P *const *d_rows;
+
+  auto operator()(size_t row) const -> P * { return d_rows[row]; }
+};
+
+template <typename T>
+auto batched_scan_scratch_size(size_t batch, size_t n) -> size_t {
+  return spwdlb_scan_scratch_size<T>(n, batch);
+}
+
+template <ScanType ST, ScanConfig CONFIG = SPWDLB_SCAN_CONFIGS[0],
+          typename InRows, typename OutRows, typename T, typename BinaryOp>
+auto batched_scan(sycl::queue &q, size_t batch, size_t n, InRows in_rows,
+                  OutRows out_rows, BinaryOp op, T identity, void *d_workspace,
+                  std::span<const sycl::event> dependences = {},
+                  sycl::event workspace_ready = {},
+                  uint32_t workspace_epoch = 0) -> sycl::event {
+  auto load = [=](size_t row, size_t gidx) -> T {
+    if constexpr (ST == ScanType::Exclusive) {
+      return gidx > 0 ? T(in_rows(row)[gidx - 1]) : identity;
+    } else if constexpr (ST == ScanType::Inclusive) {
+      return T(in_rows(row)[gidx]);
+    }
+  };
+  auto store = [=](size_t row, size_t gidx, T value) {
+    out_rows(row)[gidx] = value;
+  };
+
+  ElemBytes elem_bytes = {sizeof(*in_rows(0)), sizeof(*out_rows(0))};
+  return rows_scan_impl<CONFIG>(q, batch, n, load, store, op, identity,
+                                d_workspace, dependences, workspace_ready,
+                                workspace_epoch, elem_bytes);
+}
+
+template <ScanType ST, ScanConfig CONFIG = SPWDLB_SCAN_CONFIGS[0],
+          typename InT, typename T, typename BinaryOp>
+auto spwdlb_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                 BinaryOp op, T identity, ScanCarry<T> carry,
+                 void *d_workspace,
+                 std::span<const sycl::event> dependences = {},
+                 sycl::event workspace_ready = {},
+                 uint32_t workspace_epoch = 0) -> sycl::event {
+  auto load = [=](size_t, size_t gidx) -> T {
+    return scan_input<ST>(d_data, n, gidx, op, identity, carry);
+  };
+  auto store = [=](size_t, size_t gidx, T value) {
+    store_scan_total<ST>(d_data, n, gidx, value, op, carry);
+    d_out[gidx] = value;
+  };
+
+  return spwdlb_scan_impl<CONFIG>(q, 1, n, load, store, op, identity,
+                                  d_workspace, dependences, workspace_ready,
+                                  workspace_epoch, {sizeof(InT), sizeof(T)});
+}
+
+template <ScanType ST, typename Input, typename Output, typename T,
+          typename BinaryOp>
+auto transform_scan(sycl::queue &q, size_t n, Input input, Output output,
+                    BinaryOp op, T identity, void *d_workspace,
+                    std::span<const sycl::event> dependences = {},
+                    sycl::event workspace_ready = {}) -> sycl::event {
+  auto load = [=](size_t, size_t gidx) -> T {
+    if constexpr (ST == ScanType::Exclusive) {
+      return gidx > 0 ? T(input(gidx - 1)) : identity;
+    } else if constexpr (ST == ScanType::Inclusive) {
+      return T(input(gidx));
+    }
+  };
+  auto store = [=](size_t, size_t gidx, T value) { output(gidx, value); };
+
+  return rows_scan_impl(q, 1, n, load, store, op, identity, d_workspace,
+                        dependences, workspace_ready);
+}
+
+template <typename T> struct SegmentedValue {
+  T value;
+  // Whether a segment starts within the elements combined into value.
+  bool head;
+};
+
+// Restarts at segment heads; associative whenever op is.
+template <typename T, typename BinaryOp> struct SegmentedOp {
+  BinaryOp op;
+
+  auto operator()(const SegmentedValue<T> &a, const SegmentedValue<T> &b) const
+      -> SegmentedValue<T> {
+    return {b.head ? b.value : op(a.value, b.value), a.head || b.head};
+  }
+};
+
+// Partitions before a segment head do not contribute to its prefix.
+template <typename T>
+constexpr auto ends_look_back(const SegmentedValue<T> &x) -> bool {
+  return x.head;
+}
+
+struct HeadFlags {
+  const uint8_t *d_flags;
+
+  auto is_head(size_t gidx) const -> bool { return d_flags[gidx] != 0; }
+};
+
+// Segment s starts at element d_offsets[s]. Indices are queried in increasing
+// order, so the next segment start is searched for once and then followed.
+template <typename OffsetT> struct SegmentOffsets {
+  const OffsetT *d_offsets;
+  size_t num_segments;
+  size_t next = 0;
+  bool started = false;
+
+  auto is_head(size_t gidx) -> bool {
+    if (!started) {
+      size_t end = num_segments;
+      while (next < end) {
+        size_t mid = next + (end - next) / 2;
+        if (size_t(d_offsets[mid]) < gidx) {
+          next = mid + 1;
+        } else {
+          end = mid;
+        }
+      }
+      started = true;
+    }
+
+    while (next < num_segments && size_t(d_offsets[next]) < gidx) {
+      ++next;
+    }
+    // Empty segments share their start with the next one.
+    bool head = false;
+    while (next < num_segments && size_t(d_offsets[next]) == gidx) {
+      head = true;
+      ++next;
+    }
+    return head;
+  }
+};
+
+template <typename T> auto segmented_scan_scratch_size(size_t n) -> size_t {
+  return spwdlb_scan_scratch_size<SegmentedValue<T>>(n);
+}
+
+template <ScanType ST, typename InT, typename Heads, typename T,
+          typename BinaryOp>
+auto segmented_scan(sycl::queue &q, size_t n, const InT *d_data, Heads heads,
+                    T *d_out, BinaryOp op, T identity, void *d_workspace,
+                    std::span<const sycl::event> dependences = {},
+                    sycl::event workspace_ready = {}) -> sycl::event {
+  using Value = SegmentedValue<T>;
+
+  auto load = [=](size_t, size_t gidx) mutable -> Value {
+    bool head = heads.is_head(gidx);
+    if constexpr (ST == ScanType::Exclusive) {
+      return {head || gidx == 0 ? identity : T(d_data[gidx - 1]), head};
+    } else if constexpr (ST == ScanType::Inclusive) {
+      return {T(d_data[gidx]), head};
+    }
+  };
+  auto store = [=](size_t, size_t gidx, Value x) { d_out[gidx] = x.value; };
+
+  return rows_scan_impl(q, 1, n, load, store, SegmentedOp<T, BinaryOp>{op},
+                        Value{identity, false}, d_workspace, dependences,
+                        workspace_ready, 0, {sizeof(InT), sizeof(T)});
+}
+
+inline constexpr ScanAlgorithm SCAN_ALGORITHMS[] = {
+    ScanAlgorithm::Recursive, ScanAlgorithm::Stream, ScanAlgorithm::LookBack,
+    ScanAlgorithm::ReduceThenScan, ScanAlgorithm::SingleGroup};
+
+inline auto scan_configs(ScanAlgorithm algorithm)
+    -> std::span<const ScanConfig> {
+  switch (algorithm) {
+  case ScanAlgorithm::Recursive:
+    return RECURSIVE_SCAN_CONFIGS;
+  case ScanAlgorithm::Stream:
+    return STREAM_SCAN_CONFIGS;
+  case ScanAlgorithm::LookBack:
+    return SPWDLB_SCAN_CONFIGS;
+  case ScanAlgorithm::ReduceThenScan:
+    return REDUCE_THEN_SCAN_CONFIGS;
+  case ScanAlgorithm::SingleGroup:
+    return SINGLE_GROUP_SCAN_CONFIGS;
+  }
+  return {};
+}
+
+// Look-back and stream scans spin on their predecessors and rely on started
+// work-groups making progress.
+inline auto scan_allowed(const DeviceInfo &info, ScanAlgorithm algorithm)
+    -> bool {
+  return has_forward_progress(info) || algorithm == ScanAlgorithm::Recursive ||
+         algorithm == ScanAlgorithm::ReduceThenScan ||
+         algorithm == ScanAlgorithm::SingleGroup;
+}
+
+struct ScanDispatchEntry {
+  sycl::info::device_type device_type;
+  // Largest input the entry applies to.
+  size_t max_n;
+  ScanChoice choice;
+};
+
+// Entries are tried in order and the first one for the device type whose
+// kernels fit the device is used. Small inputs are scanned by a single
+// work-group in one launch without a workspace. Devices other than GPUs use
+// reduce-then-scan.
+inline constexpr ScanDispatchEntry SCAN_DISPATCH_TABLE[] = {
+    {sycl::info::device_type::gpu, 256,
+     {ScanAlgorithm::SingleGroup, SINGLE_GROUP_SCAN_CONFIGS[1]}},
+    {sycl::info::device_type::gpu, SINGLE_GROUP_SCAN_MAX_N,
+     {ScanAlgorithm::SingleGroup, SINGLE_GROUP_SCAN_CONFIGS[0]}},
+    {sycl::info::device_type::gpu, SIZE_MAX,
+     {ScanAlgorithm::LookBack, SPWDLB_SCAN_CONFIGS[0]}},
+    {sycl::info::device_type::gpu, SIZE_MAX,
+     {ScanAlgorithm::Stream, STREAM_SCAN_CONFIGS[0]}},
+    {sycl::info::device_type::gpu, SIZE_MAX,
+     {ScanAlgorithm::Stream, STREAM_SCAN_CONFIGS[1]}},
+    {sycl::info::device_type::cpu, SINGLE_GROUP_SCAN_MAX_N,
+     {ScanAlgorithm::SingleGroup, SINGLE_GROUP_SCAN_CONFIGS[0]}},
+    {sycl::info::device_type::cpu, SIZE_MAX,
+     {ScanAlgorithm::ReduceThenScan, REDUCE_THEN_SCAN_CONFIGS[0]}},
+    {sycl::info::device_type::accelerator, SINGLE_GROUP_SCAN_MAX_N,
+     {ScanAlgorithm::SingleGroup, SINGLE_GROUP_SCAN_CONFIGS[0]}},
+    {sycl::info::device_type::accelerator, SIZE_MAX,
+     {ScanAlgorithm::ReduceThenScan, REDUCE_THEN_SCAN_CONFIGS[0]}},
+};
+
+// A tuning of the device takes precedence over the table as long as its
+// kernel fits T.
+template <typename T>
+auto select_scan(const sycl::device &dev, size_t n) -> ScanChoice {
+  const DeviceInfo &info = get_device_info(dev);
+  for (const ScanTuning &tuning : info.scan_tunings) {
+    if (n <= tuning.max_n) {
+      const ScanChoice &choice = tuning.choice;
+      if (scan_fits<T>(dev, choice.algorithm, choice.config)) {
+        return choice;
+      }
+      break;
+    }
+  }
+  for (const ScanDispatchEntry &entry : SCAN_DISPATCH_TABLE) {
+    const ScanChoice &choice = entry.choice;
+    if (entry.device_type == info.type && n <= entry.max_n &&
+        scan_fits<T>(dev, choice.algorithm, choice.config)) {
+      return choice;
+    }
+  }
+  ScanChoice fallback = {ScanAlgorithm::ReduceThenScan,
+                         REDUCE_THEN_SCAN_CONFIGS[0]};
+  if (scan_fits<T>(dev, fallback.algorithm, fallback.config)) {
+    return fallback;
+  }
+  return {ScanAlgorithm::Recursive, RECURSIVE_SCAN_CONFIGS[0]};
+}
+
+template <typename T>
+auto scan_scratch_size(const sycl::device &dev, ScanChoice choice, size_t n)
+    -> size_t {
+  switch (choice.algorithm) {
+  case ScanAlgorithm::Recursive:
+    return recursive_scan_scratch_size<T>(n, choice.config);
+  case ScanAlgorithm::Stream:
+    return stream_scan_scratch_size<T>(choice.config, n);
+  case ScanAlgorithm::LookBack:
+    return spwdlb_scan_scratch_size<T>(n, 1, choice.config);
+  case ScanAlgorithm::ReduceThenScan:
+    return reduce_then_scan_scratch_size<T>(dev, n, choice.config);
+  case ScanAlgorithm::SingleGroup:
+    return 0;
+  }
+  return 0;
+}
+
+template <ScanType ST, typename InT, typename T, typename BinaryOp>
+auto scan(sycl::queue &q, ScanChoice choice, size_t n, const InT *d_data,
+          T *d_out, BinaryOp op, T identity, ScanCarry<T> carry,
+          void *d_workspace, std::span<const sycl::event> dependences = {},
+          sycl::event workspace_ready = {}, uint32_t workspace_epoch = 0)
+    -> sycl::event {
+  // An empty scan only passes its carry-in on.
+  if (n == 0) {
+    if (!carry.d_total) {
+      return {};
+    }
+    KernelLaunch launch = {"scan carry", 0, 2 * sizeof(T)};
+    return submit_kernel(q, launch, [&](sycl::handler &cg) {
+      depends_on(cg, dependences);
+      cg.single_task([=] { *carry.d_total = carry_in(carry); });
+    });
+  }
+
+  switch (choice.algorithm) {
+  case ScanAlgorithm::Recursive:
+    return with_scan_config<RECURSIVE_SCAN_CONFIGS>(
+        choice.config, [&]<ScanConfig CONFIG>() {
+          return recursive_scan<ST, CONFIG>(q, n, d_data, d_out, op, identity,
+                                            carry, d_workspace, dependences,
+                                            workspace_ready);
+        });
+  case ScanAlgorithm::Stream:
+    return with_scan_config<STREAM_SCAN_CONFIGS>(
+        choice.config, [&]<ScanConfig CONFIG>() {
+          return stream_scan_impl<ST, CONFIG>(
+              q, n, d_data, d_out, op, identity, carry, d_workspace,
+              dependences, workspace_ready, workspace_epoch);
+        });
+  case ScanAlgorithm::LookBack:
+    return with_scan_config<SPWDLB_SCAN_CONFIGS>(
+        choice.config, [&]<ScanConfig CONFIG>() {
+          return spwdlb_scan<ST, CONFIG>(q, n, d_data, d_out, op, identity,
+                                         carry, d_workspace, dependences,
+                                         workspace_ready, workspace_epoch);
+        });
+  case ScanAlgorithm::ReduceThenScan:
+    return with_scan_config<REDUCE_THEN_SCAN_CONFIGS>(
+        choice.config, [&]<ScanConfig CONFIG>() {
+          return reduce_then_scan<ST, CONFIG>(q, n, d_data, d_out, op,
+                                              identity, carry, d_workspace,
+                                              dependences, workspace_ready);
+        });
+  case ScanAlgorithm::SingleGroup:
+    return with_scan_config<SINGLE_GROUP_SCAN_CONFIGS>(
+        choice.config, [&]<ScanConfig CONFIG>() {
+          return single_group_scan<ST, CONFIG>(q, n, d_data, d_out, op,
+                                               identity, carry, dependences);
+        });
+  }
+  return {};
+}
+
+template <ScanType ST, typename InT, typename T, typename BinaryOp>
+auto scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out, BinaryOp op,
+          T identity, ScanCarry<T> carry,
+          std::span<const sycl::event> dependences) -> sycl::event {
+  ScanChoice choice = select_scan<T>(q.get_device(), n);
+  size_t workspace_size = scan_scratch_size<T>(q.get_device(), choice, n);
+  auto run = [&](void *d_workspace, sycl::event workspace_ready,
+                 uint32_t workspace_epoch) {
+    return scan<ST>(q, choice, n, d_data, d_out, op, identity, carry,
+                    d_workspace, dependences, workspace_ready,
+                    workspace_epoch);
+  };
+
+  // The single-launch scans keep their workspace across calls.
+  switch (choice.algorithm) {
+  case ScanAlgorithm::Stream:
+    return with_reused_workspace(
+        q, WorkspaceLayout::StreamScan, workspace_size,
+        scan_counters_size<T>(STREAM_SCAN_NUM_COUNTERS), run);
+  case ScanAlgorithm::LookBack:
+    return with_reused_workspace(
+        q, look_back_workspace_layout<T>(), workspace_size,
+        spwdlb_scan_tag_size<T>(n, 1, choice.config), run);
+  default:
+    return with_temporary_workspace(
+        q, workspace_size, [&](void *d_workspace, sycl::event workspace_ready) {
+          return run(d_workspace, workspace_ready, 0);
+        });
+  }
+}
+
+inline constexpr int HOST_SCAN_BUFFERS = 3;
+inline constexpr size_t HOST_SCAN_CHUNK_BYTES = size_t(64) << 20;
+inline constexpr size_t HOST_SCAN_ALIGNMENT = 256;
+
+template <typename InT, typename T>
+constexpr auto host_scan_chunk_elems() -> size_t {
+  return HOST_SCAN_CHUNK_BYTES / (sizeof(InT) + sizeof(T));
+}
+
+// Streams chunks of a host array through HOST_SCAN_BUFFERS device buffers.
+// Chunk k goes to buffer k % HOST_SCAN_BUFFERS on an in-order queue of its
+// own. That queue copies the chunk in, scans it once chunk k - 1 has been
+// scanned, and copies it back. The copies of neighbouring chunks therefore
+// overlap their scans, and the carry passes from chunk to chunk through a
+// ring of totals on the device. The first chunk takes the carry-in of `carry`
+// and the last one writes its total.
+template <ScanType ST, typename InT, typename T, typename BinaryOp>
+void host_scan(sycl::queue &q, size_t n, const InT *data, T *out, BinaryOp op,
+               T identity, ScanCarry<T> carry, size_t chunk_elems) {
+  if (n == 0) {
+    scan<ST>(q, ScanChoice{}, 0, data, out, op, identity, carry, nullptr)
+        .wait();
+    return;
+  }
+
+  if (chunk_elems == 0) {
+    chunk_elems = host_scan_chunk_elems<InT, T>();
+  }
+  chunk_elems = std::min(chunk_elems, n);
+  size_t num_chunks = ceil_div(n, chunk_elems);
+  size_t num_buffers = std::min<size_t>(num_chunks, HOST_SCAN_BUFFERS);
+  size_t last_elems = n - (num_chunks - 1) * chunk_elems;
+
+  // The last chunk may be scanned differently from the others.
+  const sycl::device &dev = q.get_device();
+  ScanChoice choice = select_scan<T>(dev, chunk_elems);
+  ScanChoice last_choice = select_scan<T>(dev, last_elems);
+  size_t scan_bytes =
+      std::max(scan_scratch_size<T>(dev, choice, chunk_elems),
+               scan_scratch_size<T>(dev, last_choice, last_elems));
+
+  size_t in_bytes = align_up(sizeof(InT) * chunk_elems, HOST_SCAN_ALIGNMENT);
+  size_t out_bytes = align_up(sizeof(T) * chunk_elems, HOST_SCAN_ALIGNMENT);
+  size_t buffer_bytes =
+      in_bytes + out_bytes + align_up(scan_bytes, HOST_SCAN_ALIGNMENT);
+  size_t bytes = buffer_bytes * num_buffers + sizeof(T) * num_buffers;
+
+  with_temporary_workspace(
+      q, bytes, [&](void *d_workspace, sycl::event workspace_ready) {
+        auto *d_buffers = static_cast<std::byte *>(d_workspace);
+        auto *d_totals =
+            reinterpret_cast<T *>(d_buffers + buffer_bytes * num_buffers);
+
+        std::vector<sycl::queue> queues;
+        for (size_t b = 0; b < num_buffers; ++b) {
+          queues.emplace_back(q.get_context(), dev,
+                              sycl::property::queue::in_order());
+        }
+
+        sycl::event scanned;
+        for (size_t k = 0; k < num_chunks; ++k) {
+          size_t b = k % num_buffers;
+          sycl::queue &bq = queues[b];
+          std::byte *d_buffer = d_buffers + b * buffer_bytes;
+          auto *d_in = reinterpret_cast<InT *>(d_buffer);
+          auto *d_out = reinterpret_cast<T *>(d_buffer + in_bytes);
+          void *d_scan_workspace = d_buffer + in_bytes + out_bytes;
+
+          size_t offset = k * chunk_elems;
+          size_t count = k + 1 < num_chunks ? chunk_elems : last_elems;
+
+          ScanCarry<T> chunk_carry = carry;
+          if (k > 0) {
+            chunk_carry.d_init = d_totals + (k - 1) % num_buffers;
+          }
+          if (k + 1 < num_chunks) {
+            chunk_carry.d_total = d_totals + b;
+          }
+
+          bq.copy(data + offset, d_in, count, workspace_ready);
+          sycl::event dependences[] = {scanned};
+          scanned = scan<ST>(bq, k + 1 < num_chunks ? choice : last_choice,
+                             count, d_in, d_out, op, identity, chunk_carry,
+                             d_scan_workspace, dependences);
+          bq.copy(d_out, out + offset, count);
+        }
+
+        for (auto &bq : queues) {
+          bq.wait();
+        }
+        return sycl::event();
+      });
+}
+
+} // namespace syclalgo::detail
+
+namespace syclalgo {
+
+template <typename T>
+auto scan_workspace_size(sycl::queue &q, size_t n) -> size_t {
+  auto choice = detail::select_scan<T>(q.get_device(), n);
+  return detail::scan_scratch_size<T>(q.get_device(), choice, n);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                    BinaryOp op, std::type_identity_t<T> identity,
+                    std::span<const sycl::event> dependences) -> sycl::event {
+  return exclusive_scan(q, n, d_data, d_out, op, identity, {identity},
+                        dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                    BinaryOp op, std::type_identity_t<T> identity,
+                    void *d_workspace, std::span<const sycl::event> dependences)
+    -> sycl::event {
+  auto choice = detail::select_scan<T>(q.get_device(), n);
+  return detail::scan<detail::ScanType::Exclusive>(
+      q, choice, n, d_data, d_out, op, identity, {identity}, d_workspace,
+      dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                    BinaryOp op, std::type_identity_t<T> identity,
+                    std::span<const sycl::event> dependences) -> sycl::event {
+  return inclusive_scan(q, n, d_data, d_out, op, identity, {identity},
+                        dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                    BinaryOp op, std::type_identity_t<T> identity,
+                    void *d_workspace, std::span<const sycl::event> dependences)
+    -> sycl::event {
+  auto choice = detail::select_scan<T>(q.get_device(), n);
+  return detail::scan<detail::ScanType::Inclusive>(
+      q, choice, n, d_data, d_out, op, identity, {identity}, d_workspace,
+      dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                    BinaryOp op, std::type_identity_t<T> identity,
+                    ScanCarry<std::type_identity_t<T>> carry,
+                    std::span<const sycl::event> dependences) -> sycl::event {
+  return detail::scan<detail::ScanType::Exclusive>(
+      q, n, d_data, d_out, op, identity, carry, dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                    BinaryOp op, std::type_identity_t<T> identity,
+                    ScanCarry<std::type_identity_t<T>> carry,
+                    void *d_workspace, std::span<const sycl::event> dependences)
+    -> sycl::event {
+  auto choice = detail::select_scan<T>(q.get_device(), n);
+  return detail::scan<detail::ScanType::Exclusive>(
+      q, choice, n, d_data, d_out, op, identity, carry, d_workspace,
+      dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                    BinaryOp op, std::type_identity_t<T> identity,
+                    ScanCarry<std::type_identity_t<T>> carry,
+                    std::span<const sycl::event> dependences) -> sycl::event {
+  return detail::scan<detail::ScanType::Inclusive>(
+      q, n, d_data, d_out, op, identity, carry, dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                    BinaryOp op, std::type_identity_t<T> identity,
+                    ScanCarry<std::type_identity_t<T>> carry,
+                    void *d_workspace, std::span<const sycl::event> dependences)
+    -> sycl::event {
+  auto choice = detail::select_scan<T>(q.get_device(), n);
+  return detail::scan<detail::ScanType::Inclusive>(
+      q, choice, n, d_data, d_out, op, identity, carry, d_workspace,
+      dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+void exclusive_host_scan(sycl::queue &q, size_t n, const InT *data, T *out,
+                         BinaryOp op, std::type_identity_t<T> identity,
+                         size_t chunk_elems) {
+  detail::host_scan<detail::ScanType::Exclusive>(
+      q, n, data, out, op, identity, {identity}, chunk_elems);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+void inclusive_host_scan(sycl::queue &q, size_t n, const InT *data, T *out,
+                         BinaryOp op, std::type_identity_t<T> identity,
+                         size_t chunk_elems) {
+  detail::host_scan<detail::ScanType::Inclusive>(
+      q, n, data, out, op, identity, {identity}, chunk_elems);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+void exclusive_host_scan(sycl::queue &q, size_t n, const InT *data, T *out,
+                         BinaryOp op, std::type_identity_t<T> identity,
+                         ScanCarry<std::type_identity_t<T>> carry,
+                         size_t chunk_elems) {
+  detail::host_scan<detail::ScanType::Exclusive>(q, n, data, out, op, identity,
+                                                 carry, chunk_elems);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+void inclusive_host_scan(sycl::queue &q, size_t n, const InT *data, T *out,
+                         BinaryOp op, std::type_identity_t<T> identity,
+                         ScanCarry<std::type_identity_t<T>> carry,
+                         size_t chunk_elems) {
+  detail::host_scan<detail::ScanType::Inclusive>(q, n, data, out, op, identity,
+                                                 carry, chunk_elems);
+}
+
+template <typename T>
+auto recursive_scan_workspace_size(sycl::queue &, size_t n) -> size_t {
+  return detail::recursive_scan_scratch_size<T>(n);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_recursive_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::with_temporary_workspace(
+      q, recursive_scan_workspace_size<T>(q, n),
+      [&](void *d_workspace, sycl::event workspace_ready) {
+        return detail::recursive_scan<detail::ScanType::Exclusive>(
+            q, n, d_data, d_out, op, identity, {identity}, d_workspace,
+            dependences, workspace_ready);
+      });
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_recursive_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              void *d_workspace,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::recursive_scan<detail::ScanType::Exclusive>(
+      q, n, d_data, d_out, op, identity, {identity}, d_workspace, dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_recursive_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::with_temporary_workspace(
+      q, recursive_scan_workspace_size<T>(q, n),
+      [&](void *d_workspace, sycl::event workspace_ready) {
+        return detail::recursive_scan<detail::ScanType::Inclusive>(
+            q, n, d_data, d_out, op, identity, {identity}, d_workspace,
+            dependences, workspace_ready);
+      });
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_recursive_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              void *d_workspace,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::recursive_scan<detail::ScanType::Inclusive>(
+      q, n, d_data, d_out, op, identity, {identity}, d_workspace, dependences);
+}
+
+template <typename T>
+auto stream_scan_workspace_size(sycl::queue &q, size_t n) -> size_t {
+  return detail::stream_scan_scratch_size<T>(
+      detail::stream_scan_config<T>(q.get_device()), n);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_stream_scan(sycl::queue &q, size_t n, const InT *d_data,
+                           T *d_out, BinaryOp op,
+                           std::type_identity_t<T> identity,
+                           std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::with_reused_workspace(
+      q, detail::WorkspaceLayout::StreamScan,
+      stream_scan_workspace_size<T>(q, n),
+      detail::scan_counters_size<T>(detail::STREAM_SCAN_NUM_COUNTERS),
+      [&](void *d_workspace, sycl::event workspace_ready,
+          uint32_t workspace_epoch) {
+        return detail::stream_scan<detail::ScanType::Exclusive>(
+            q, n, d_data, d_out, op, identity, {identity}, d_workspace,
+            dependences, workspace_ready, workspace_epoch);
+      });
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_stream_scan(sycl::queue &q, size_t n, const InT *d_data,
+                           T *d_out, BinaryOp op,
+                           std::type_identity_t<T> identity, void *d_workspace,
+                           std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::stream_scan<detail::ScanType::Exclusive>(
+      q, n, d_data, d_out, op, identity, {identity}, d_workspace, dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_stream_scan(sycl::queue &q, size_t n, const InT *d_data,
+                           T *d_out, BinaryOp op,
+                           std::type_identity_t<T> identity,
+                           std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::with_reused_workspace(
+      q, detail::WorkspaceLayout::StreamScan,
+      stream_scan_workspace_size<T>(q, n),
+      detail::scan_counters_size<T>(detail::STREAM_SCAN_NUM_COUNTERS),
+      [&](void *d_workspace, sycl::event workspace_ready,
+          uint32_t workspace_epoch) {
+        return detail::stream_scan<detail::ScanType::Inclusive>(
+            q, n, d_data, d_out, op, identity, {identity}, d_workspace,
+            dependences, workspace_ready, workspace_epoch);
+      });
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_stream_scan(sycl::queue &q, size_t n, const InT *d_data,
+                           T *d_out, BinaryOp op,
+                           std::type_identity_t<T> identity, void *d_workspace,
+                           std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::stream_scan<detail::ScanType::Inclusive>(
+      q, n, d_data, d_out, op, identity, {identity}, d_workspace, dependences);
+}
+
+template <typename T>
+auto spwdlb_scan_workspace_size(sycl::queue &, size_t n) -> size_t {
+  return detail::spwdlb_scan_scratch_size<T>(n);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_spwdlb_scan(sycl::queue &q, size_t n, const InT *d_data,
+                           T *d_out, BinaryOp op,
+                           std::type_identity_t<T> identity,
+                           std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::with_reused_workspace(
+      q, detail::look_back_workspace_layout<T>(),
+      spwdlb_scan_workspace_size<T>(q, n), detail::spwdlb_scan_tag_size<T>(n),
+      [&](void *d_workspace, sycl::event workspace_ready,
+          uint32_t workspace_epoch) {
+        return detail::spwdlb_scan<detail::ScanType::Exclusive>(
+            q, n, d_data, d_out, op, identity, {identity}, d_workspace,
+            dependences, workspace_ready, workspace_epoch);
+      });
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_spwdlb_scan(sycl::queue &q, size_t n, const InT *d_data,
+                           T *d_out, BinaryOp op,
+                           std::type_identity_t<T> identity, void *d_workspace,
+                           std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::spwdlb_scan<detail::ScanType::Exclusive>(
+      q, n, d_data, d_out, op, identity, {identity}, d_workspace, dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_spwdlb_scan(sycl::queue &q, size_t n, const InT *d_data,
+                           T *d_out, BinaryOp op,
+                           std::type_identity_t<T> identity,
+                           std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::with_reused_workspace(
+      q, detail::look_back_workspace_layout<T>(),
+      spwdlb_scan_workspace_size<T>(q, n), detail::spwdlb_scan_tag_size<T>(n),
+      [&](void *d_workspace, sycl::event workspace_ready,
+          uint32_t workspace_epoch) {
+        return detail::spwdlb_scan<detail::ScanType::Inclusive>(
+            q, n, d_data, d_out, op, identity, {identity}, d_workspace,
+            dependences, workspace_ready, workspace_epoch);
+      });
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_spwdlb_scan(sycl::queue &q, size_t n, const InT *d_data,
+                           T *d_out, BinaryOp op,
+                           std::type_identity_t<T> identity, void *d_workspace,
+                           std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::spwdlb_scan<detail::ScanType::Inclusive>(
+      q, n, d_data, d_out, op, identity, {identity}, d_workspace, dependences);
+}
+
+template <typename T>
+auto reduce_then_scan_workspace_size(sycl::queue &q, size_t n) -> size_t {
+  return detail::reduce_then_scan_scratch_size<T>(q.get_device(), n);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_reduce_then_scan(sycl::queue &q, size_t n, const InT *d_data,
+                                T *d_out, BinaryOp op,
+                                std::type_identity_t<T> identity,
+                                std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::with_temporary_workspace(
+      q, reduce_then_scan_workspace_size<T>(q, n),
+      [&](void *d_workspace, sycl::event workspace_ready) {
+        return detail::reduce_then_scan<detail::ScanType::Exclusive>(
+            q, n, d_data, d_out, op, identity, {identity}, d_workspace,
+            dependences, workspace_ready);
+      });
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_reduce_then_scan(sycl::queue &q, size_t n, const InT *d_data,
+                                T *d_out, BinaryOp op,
+                                std::type_identity_t<T> identity,
+                                void *d_workspace,
+                                std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::reduce_then_scan<detail::ScanType::Exclusive>(
+      q, n, d_data, d_out, op, identity, {identity}, d_workspace, dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_reduce_then_scan(sycl::queue &q, size_t n, const InT *d_data,
+                                T *d_out, BinaryOp op,
+                                std::type_identity_t<T> identity,
+                                std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::with_temporary_workspace(
+      q, reduce_then_scan_workspace_size<T>(q, n),
+      [&](void *d_workspace, sycl::event workspace_ready) {
+        return detail::reduce_then_scan<detail::ScanType::Inclusive>(
+            q, n, d_data, d_out, op, identity, {identity}, d_workspace,
+            dependences, workspace_ready);
+      });
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_reduce_then_scan(sycl::queue &q, size_t n, const InT *d_data,
+                                T *d_out, BinaryOp op,
+                                std::type_identity_t<T> identity,
+                                void *d_workspace,
+                                std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::reduce_then_scan<detail::ScanType::Inclusive>(
+      q, n, d_data, d_out, op, identity, {identity}, d_workspace, dependences);
+}
+
+template <typename T>
+auto segmented_scan_workspace_size(sycl::queue &, size_t n) -> size_t {
+  return detail::segmented_scan_scratch_size<T>(n);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_segmented_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              const uint8_t *d_head_flags, T *d_out,
+                              BinaryOp op, std::type_identity_t<T> identity,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  detail::HeadFlags heads{d_head_flags};
+  return detail::with_temporary_workspace(
+      q, segmented_scan_workspace_size<T>(q, n),
+      [&](void *d_workspace, sycl::event workspace_ready) {
+        return detail::segmented_scan<detail::ScanType::Exclusive>(
+            q, n, d_data, heads, d_out, op, identity, d_workspace, dependences,
+            workspace_ready);
+      });
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_segmented_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              const uint8_t *d_head_flags, T *d_out,
+                              BinaryOp op, std::type_identity_t<T> identity,
+                              void *d_workspace,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  detail::HeadFlags heads{d_head_flags};
+  return detail::segmented_scan<detail::ScanType::Exclusive>(
+      q, n, d_data, heads, d_out, op, identity, d_workspace, dependences);
+}
+
+template <typename InT, typename OffsetT, typename T, typename BinaryOp>
+auto exclusive_segmented_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              size_t num_segments, const OffsetT *d_offsets,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  detail::SegmentOffsets<OffsetT> heads{d_offsets, num_segments};
+  return detail::with_temporary_workspace(
+      q, segmented_scan_workspace_size<T>(q, n),
+      [&](void *d_workspace, sycl::event workspace_ready) {
+        return detail::segmented_scan<detail::ScanType::Exclusive>(
+            q, n, d_data, heads, d_out, op, identity, d_workspace, dependences,
+            workspace_ready);
+      });
+}
+
+template <typename InT, typename OffsetT, typename T, typename BinaryOp>
+auto exclusive_segmented_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              size_t num_segments, const OffsetT *d_offsets,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              void *d_workspace,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  detail::SegmentOffsets<OffsetT> heads{d_offsets, num_segments};
+  return detail::segmented_scan<detail::ScanType::Exclusive>(
+      q, n, d_data, heads, d_out, op, identity, d_workspace, dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_segmented_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              const uint8_t *d_head_flags, T *d_out,
+                              BinaryOp op, std::type_identity_t<T> identity,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  detail::HeadFlags heads{d_head_flags};
+  return detail::with_temporary_workspace(
+      q, segmented_scan_workspace_size<T>(q, n),
+      [&](void *d_workspace, sycl::event workspace_ready) {
+        return detail::segmented_scan<detail::ScanType::Inclusive>(
+            q, n, d_data, heads, d_out, op, identity, d_workspace, dependences,
+            workspace_ready);
+      });
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_segmented_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              const uint8_t *d_head_flags, T *d_out,
+                              BinaryOp op, std::type_identity_t<T> identity,
+                              void *d_workspace,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  detail::HeadFlags heads{d_head_flags};
+  return detail::segmented_scan<detail::ScanType::Inclusive>(
+      q, n, d_data, heads, d_out, op, identity, d_workspace, dependences);
+}
+
+template <typename InT, typename OffsetT, typename T, typename BinaryOp>
+auto inclusive_segmented_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              size_t num_segments, const OffsetT *d_offsets,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  detail::SegmentOffsets<OffsetT> heads{d_offsets, num_segments};
+  return detail::with_temporary_workspace(
+      q, segmented_scan_workspace_size<T>(q, n),
+      [&](void *d_workspace, sycl::event workspace_ready) {
+        return detail::segmented_scan<detail::ScanType::Inclusive>(
+            q, n, d_data, heads, d_out, op, identity, d_workspace, dependences,
+            workspace_ready);
+      });
+}
+
+template <typename InT, typename OffsetT, typename T, typename BinaryOp>
+auto inclusive_segmented_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              size_t num_segments, const OffsetT *d_offsets,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              void *d_workspace,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  detail::SegmentOffsets<OffsetT> heads{d_offsets, num_segments};
+  return detail::segmented_scan<detail::ScanType::Inclusive>(
+      q, n, d_data, heads, d_out, op, identity, d_workspace, dependences);
+}
+
+template <typename T>
+auto batched_scan_workspace_size(sycl::queue &, size_t batch, size_t n)
+    -> size_t {
+  return detail::batched_scan_scratch_size<T>(batch, n);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto batched_exclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            size_t stride, const InT *d_data, T *d_out,
+                            BinaryOp op, std::type_identity_t<T> identity,
+                            std::span<const sycl::event> dependences)
+    -> sycl::event {
+  detail::StridedRows<const InT> in_rows{d_data, stride};
+  detail::StridedRows<T> out_rows{d_out, stride};
+  return detail::with_temporary_workspace(
+      q, batched_scan_workspace_size<T>(q, batch, n),
+      [&](void *d_workspace, sycl::event workspace_ready) {
+        return detail::batched_scan<detail::ScanType::Exclusive>(
+            q, batch, n, in_rows, out_rows, op, identity, d_workspace,
+            dependences, workspace_ready);
+      });
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto batched_exclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            size_t stride, const InT *d_data, T *d_out,
+                            BinaryOp op, std::type_identity_t<T> identity,
+                            void *d_workspace,
+                            std::span<const sycl::event> dependences)
+    -> sycl::event {
+  detail::StridedRows<const InT> in_rows{d_data, stride};
+  detail::StridedRows<T> out_rows{d_out, stride};
+  return detail::batched_scan<detail::ScanType::Exclusive>(
+      q, batch, n, in_rows, out_rows, op, identity, d_workspace, dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto batched_exclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            const InT *const *d_data, T *const *d_out,
+                            BinaryOp op, std::type_identity_t<T> identity,
+                            std::span<const sycl::event> dependences)
+    -> sycl::event {
+  detail::IndirectRows<const InT> in_rows{d_data};
+  detail::IndirectRows<T> out_rows{d_out};
+  return detail::with_temporary_workspace(
+      q, batched_scan_workspace_size<T>(q, batch, n),
+      [&](void *d_workspace, sycl::event workspace_ready) {
+        return detail::batched_scan<detail::ScanType::Exclusive>(
+            q, batch, n, in_rows, out_rows, op, identity, d_workspace,
+            dependences, workspace_ready);
+      });
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto batched_exclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            const InT *const *d_data, T *const *d_out,
+                            BinaryOp op, std::type_identity_t<T> identity,
+                            void *d_workspace,
+                            std::span<const sycl::event> dependences)
+    -> sycl::event {
+  detail::IndirectRows<const InT> in_rows{d_data};
+  detail::IndirectRows<T> out_rows{d_out};
+  return detail::batched_scan<detail::ScanType::Exclusive>(
+      q, batch, n, in_rows, out_rows, op, identity, d_workspace, dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto batched_inclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            size_t stride, const InT *d_data, T *d_out,
+                            BinaryOp op, std::type_identity_t<T> identity,
+                            std::span<const sycl::event> dependences)
+    -> sycl::event {
+  detail::StridedRows<const InT> in_rows{d_data, stride};
+  detail::StridedRows<T> out_rows{d_out, stride};
+  return detail::with_temporary_workspace(
+      q, batched_scan_workspace_size<T>(q, batch, n),
+      [&](void *d_workspace, sycl::event workspace_ready) {
+        return detail::batched_scan<detail::ScanType::Inclusive>(
+            q, batch, n, in_rows, out_rows, op, identity, d_workspace,
+            dependences, workspace_ready);
+      });
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto batched_inclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            size_t stride, const InT *d_data, T *d_out,
+                            BinaryOp op, std::type_identity_t<T> identity,
+                            void *d_workspace,
+                            std::span<const sycl::event> dependences)
+    -> sycl::event {
+  detail::StridedRows<const InT> in_rows{d_data, stride};
+  detail::StridedRows<T> out_rows{d_out, stride};
+  return detail::batched_scan<detail::ScanType::Inclusive>(
+      q, batch, n, in_rows, out_rows, op, identity, d_workspace, dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto batched_inclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            const InT *const *d_data, T *const *d_out,
+                            BinaryOp op, std::type_identity_t<T> identity,
+                            std::span<const sycl::event> dependences)
+    -> sycl::event {
+  detail::IndirectRows<const InT> in_rows{d_data};
+  detail::IndirectRows<T> out_rows{d_out};
+  return detail::with_temporary_workspace(
+      q, batched_scan_workspace_size<T>(q, batch, n),
+      [&](void *d_workspace, sycl::event workspace_ready) {
+        return detail::batched_scan<detail::ScanType::Inclusive>(
+            q, batch, n, in_rows, out_rows, op, identity, d_workspace,
+            dependences, workspace_ready);
+      });
+}
+
+template <typename InT, typename T, typename BinaryOp>
+auto batched_inclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            const InT *const *d_data, T *const *d_out,
+                            BinaryOp op, std::type_identity_t<T> identity,
+                            void *d_workspace,
+                            std::span<const sycl::event> dependences)
+    -> sycl::event {
+  detail::IndirectRows<const InT> in_rows{d_data};
+  detail::IndirectRows<T> out_rows{d_out};
+  return detail::batched_scan<detail::ScanType::Inclusive>(
+      q, batch, n, in_rows, out_rows, op, identity, d_workspace, dependences);
+}
+
+template <typename T>
+auto transform_scan_workspace_size(sycl::queue &, size_t n) -> size_t {
+  return detail::spwdlb_scan_scratch_size<T>(n);
+}
+
+template <typename InT, typename T, typename BinaryOp, typename UnaryOp>
+auto transform_exclusive_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              UnaryOp transform,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  auto input = [=](size_t i) { return transform(d_data[i]); };
+  auto output = [=](size_t i, T value) { d_out[i] = value; };
+  return transform_exclusive_scan(q, n, input, output, op, identity,
+                                  dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp, typename UnaryOp>
+auto transform_exclusive_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              UnaryOp transform, void *d_workspace,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  auto input = [=](size_t i) { return transform(d_data[i]); };
+  auto output = [=](size_t i, T value) { d_out[i] = value; };
+  return transform_exclusive_scan(q, n, input, output, op, identity,
+                                  d_workspace, dependences);
+}
+
+template <typename Input, typename Output, typename T, typename BinaryOp>
+auto transform_exclusive_scan(sycl::queue &q, size_t n, Input input,
+                              Output output, BinaryOp op, T identity,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::with_temporary_workspace(
+      q, transform_scan_workspace_size<T>(q, n),
+      [&](void *d_workspace, sycl::event workspace_ready) {
+        return detail::transform_scan<detail::ScanType::Exclusive>(
+            q, n, input, output, op, identity, d_workspace, dependences,
+            workspace_ready);
+      });
+}
+
+template <typename Input, typename Output, typename T, typename BinaryOp>
+auto transform_exclusive_scan(sycl::queue &q, size_t n, Input input,
+                              Output output, BinaryOp op, T identity,
+                              void *d_workspace,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::transform_scan<detail::ScanType::Exclusive>(
+      q, n, input, output, op, identity, d_workspace, dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp, typename UnaryOp>
+auto transform_inclusive_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              UnaryOp transform,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  auto input = [=](size_t i) { return transform(d_data[i]); };
+  auto output = [=](size_t i, T value) { d_out[i] = value; };
+  return transform_inclusive_scan(q, n, input, output, op, identity,
+                                  dependences);
+}
+
+template <typename InT, typename T, typename BinaryOp, typename UnaryOp>
+auto transform_inclusive_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              UnaryOp transform, void *d_workspace,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  auto input = [=](size_t i) { return transform(d_data[i]); };
+  auto output = [=](size_t i, T value) { d_out[i] = value; };
+  return transform_inclusive_scan(q, n, input, output, op, identity,
+                                  d_workspace, dependences);
+}
+
+template <typename Input, typename Output, typename T, typename BinaryOp>
+auto transform_inclusive_scan(sycl::queue &q, size_t n, Input input,
+                              Output output, BinaryOp op, T identity,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::with_temporary_workspace(
+      q, transform_scan_workspace_size<T>(q, n),
+      [&](void *d_workspace, sycl::event workspace_ready) {
+        return detail::transform_scan<detail::ScanType::Inclusive>(
+            q, n, input, output, op, identity, d_workspace, dependences,
+            workspace_ready);
+      });
+}
+
+template <typename Input, typename Output, typename T, typename BinaryOp>
+auto transform_inclusive_scan(sycl::queue &q, size_t n, Input input,
+                              Output output, BinaryOp op, T identity,
+                              void *d_workspace,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::transform_scan<detail::ScanType::Inclusive>(
+      q, n, input, output, op, identity, d_workspace, dependences);
+}
+
+} // namespace syclalgo
@@ -0,0 +1,307 @@
+#pragma once
+#include "syclalgo-detail.hpp"
+#include "syclalgo-reduce.hpp"
+#include "syclalgo-scan.hpp"
+#include "syclalgo.hpp"
+#include <algorithm>
+
+namespace syclalgo::detail {
+
+inline constexpr int SELECT_BLOCK_SIZE = 256;
+inline constexpr int SELECT_ELEMS = 7;
+
+template <typename CountT> auto select_bid_offset(size_t n) -> size_t {
+  constexpr int BLOCK_ELEMS = SELECT_BLOCK_SIZE * SELECT_ELEMS;
+  size_t num_groups = ceil_div(n, BLOCK_ELEMS);
+  return align_up(PartitionDescriptors<CountT>::storage_size(num_groups),
+                  alignof(int));
+}
+
+// Local memory of the select kernel when it stages its output there.
+template <typename T, typename CountT>
+constexpr auto select_local_mem_size() -> size_t {
+  return sizeof(T) * SELECT_BLOCK_SIZE * SELECT_ELEMS +
+         sizeof(CountT) * group_inclusive_scan_shm_size(SELECT_BLOCK_SIZE) +
+         sizeof(int);
+}
+
+// count_if reduces its count in the same workspace.
+inline auto select_scratch_size(size_t n) -> size_t {
+  return with_count_type(n, [&](auto count) {
+    return std::max(select_bid_offset<decltype(count)>(n) + sizeof(int),
+                    reduce_scratch_size<size_t>(n));
+  });
+}
+
+// Stable selection in a single pass. Elements satisfying `pred` are written to
+// d_selected and, if given, the others to d_rejected, both in input order. On
+// devices without forward progress, the selected elements of every block are
+// counted and scanned first, in the place of the partition descriptors, and
+// the pass reads the prefixes instead of looking back.
+template <typename CountT, typename T, typename Pred>
+auto select_impl(sycl::queue &q, size_t n, const T *d_data, T *d_selected,
+                 T *d_rejected, Pred pred, size_t *d_num_selected,
+                 void *d_workspace, std::span<const sycl::event> dependences,
+                 sycl::event workspace_ready) -> sycl::event {
+  constexpr int BLOCK_SIZE = SELECT_BLOCK_SIZE;
+  constexpr int ELEMS = SELECT_ELEMS;
+  constexpr int BLOCK_ELEMS = BLOCK_SIZE * ELEMS;
+
+  size_t num_groups = ceil_div(n, BLOCK_ELEMS);
+  if (num_groups == 0) {
+    KernelLaunch launch = {"select empty", 0, sizeof(size_t)};
+    return submit_kernel(q, launch, [&](sycl::handler &cg) {
+      depends_on(cg, dependences);
+      cg.single_task([=] { *d_num_selected = 0; });
+    });
+  }
+
+  PartitionDescriptors<CountT> descriptors(d_workspace, num_groups);
+  auto *d_block_prefixes = static_cast<CountT *>(d_workspace);
+  auto *d_bid = reinterpret_cast<int *>(static_cast<std::byte *>(d_workspace) +
+                                        select_bid_offset<CountT>(n));
+
+  const DeviceInfo &info = get_device_info(q.get_device());
+  bool use_look_back = has_forward_progress(info);
+  // Elements too wide to stage a whole block in local memory are written
+  // straight to their outputs.
+  bool stage = select_local_mem_size<T, CountT>() <= info.local_mem_size;
+
+  sycl::event e;
+  if (use_look_back) {
+    e = reset_partitions(q, n, descriptors, d_bid, num_groups, dependences,
+                         workspace_ready);
+  } else {
+    KernelLaunch count = {"select count", n,
+                          sizeof(T) * n + sizeof(CountT) * num_groups};
+    e = submit_kernel(q, count, [&](sycl::handler &cg) {
+      depends_on(cg, dependences);
+      cg.depends_on(workspace_ready);
+
+      sycl::nd_range<1> range = {num_groups * BLOCK_SIZE, BLOCK_SIZE};
+      cg.parallel_for(range, [=](sycl::nd_item<1> id) {
+        auto g = id.get_group();
+        int lid = id.get_local_id();
+        size_t bid = g.get_group_id();
+        size_t thread_offset = bid * BLOCK_ELEMS + lid * ELEMS;
+
+        CountT count = 0;
+        for (int i = 0; i < ELEMS && thread_offset + i < n; ++i) {
+          count += pred(d_data[thread_offset + i]);
+        }
+        count = sycl::reduce_over_group(g, count, sycl::plus<CountT>());
+        if (g.leader()) {
+          d_block_prefixes[bid] = count;
+        }
+      });
+    });
+
+    KernelLaunch scan_counts = {"select count scan", n,
+                                2 * sizeof(CountT) * num_groups +
+                                    sizeof(size_t)};
+    e = scan_tile_sums<BLOCK_SIZE>(
+        q, scan_counts, d_block_prefixes, 1, num_groups,
+        sycl::plus<CountT>(), CountT(0),
+        [=](size_t, CountT total) { *d_num_selected = total; }, e);
+  }
+
+  KernelLaunch select = {"select", n, 2 * sizeof(T) * n + sizeof(size_t)};
+  e = submit_kernel(q, select, [&](sycl::handler &cg) {
+    sycl::local_accessor<T> shm(stage ? BLOCK_ELEMS : 1, cg);
+    sycl::local_accessor<CountT> scan_shm(
+        group_inclusive_scan_shm_size(BLOCK_SIZE), cg);
+    sycl::local_accessor<int> bid_shm(1, cg);
+
+    cg.depends_on(e);
+    depends_on(cg, dependences);
+
+    sycl::nd_range<1> range = {num_groups * BLOCK_SIZE, BLOCK_SIZE};
+    cg.parallel_for(range, [=](sycl::nd_item<1> id) {
+      auto g = id.get_group();
+      auto sg = id.get_sub_group();
+      int lid = id.get_local_id();
+
+      int bid = use_look_back ? next_partition(id, d_bid, bid_shm, num_groups)
+                              : int(g.get_group_id());
+
+      size_t block_offset = size_t(bid) * BLOCK_ELEMS;
+      size_t thread_offset = block_offset + lid * ELEMS;
+
+      T values[ELEMS];
+      bool flags[ELEMS];
+      CountT count = 0;
+      for (int i = 0; i < ELEMS; ++i) {
+        size_t gidx = thread_offset + i;
+        flags[i] = false;
+        if (gidx < n) {
+          values[i] = d_data[gidx];
+          flags[i] = pred(values[i]);
+        }
+        count += flags[i];
+      }
+      scan_shm[lid] = count;
+
+      group_inclusive_scan<BLOCK_SIZE, 1, CountT>(id, scan_shm,
+                                                  sycl::plus<CountT>());
+
+      CountT block_count = scan_shm[BLOCK_SIZE - 1];
+      CountT thread_prefix = lid > 0 ? scan_shm[lid - 1] : 0;
+      sycl::group_barrier(g);
+
+      if (!use_look_back) {
+        if (g.leader()) {
+          scan_shm[0] = d_block_prefixes[bid];
+        }
+      } else if (sg.get_group_linear_id() == 0) {
+        CountT block_prefix =
+            sub_group_look_back(sg, descriptors, bid, bid == 0, block_count,
+                                sycl::plus<CountT>(), CountT(0));
+        if (sg.leader()) {
+          if (size_t(bid) == num_groups - 1) {
+            *d_num_selected = block_prefix + block_count;
+          }
+          scan_shm[0] = block_prefix;
+        }
+      }
+      sycl::group_barrier(g);
+
+      CountT block_prefix = scan_shm[0];
+      size_t rejected_prefix = block_offset - block_prefix;
+
+      if (!stage) {
+        CountT selected = block_prefix + thread_prefix;
+        size_t rejected = rejected_prefix + lid * ELEMS - thread_prefix;
+        for (int i = 0; i < ELEMS; ++i) {
+          if (flags[i]) {
+            d_selected[selected++] = values[i];
+          } else if (d_rejected && thread_offset + i < n) {
+            d_rejected[rejected++] = values[i];
+          }
+        }
+        return;
+      }
+
+      // Stage the output of the block in local memory, selected elements
+      // first, so that the global writes are coalesced.
+      CountT selected = thread_prefix;
+      CountT rejected = block_count + lid * ELEMS - thread_prefix;
+      for (int i = 0; i < ELEMS; ++i) {
+        if (flags[i]) {
+          shm[selected++] = values[i];
+        } else if (d_rejected && thread_offset + i < n) {
+          shm[rejected++] = values[i];
+        }
+      }
+      sycl::group_barrier(g);
+
+      size_t block_elems = std::min<size_t>(BLOCK_ELEMS, n - block_offset);
+      size_t num_staged = d_rejected ? block_elems : block_count;
+      for (size_t j = lid; j < num_staged; j += BLOCK_SIZE) {
+        if (j < block_count) {
+          d_selected[block_prefix + j] = shm[j];
+        } else {
+          d_rejected[rejected_prefix + j - block_count] = shm[j];
+        }
+      }
+    });
+  });
+
+  return e;
+}
+
+template <typename T, typename Pred>
+auto select(sycl::queue &q, size_t n, const T *d_data, T *d_selected,
+            T *d_rejected, Pred pred, size_t *d_num_selected,
+            void *d_workspace, std::span<const sycl::event> dependences = {},
+            sycl::event workspace_ready = {}) -> sycl::event {
+  return with_count_type(n, [&](auto count) {
+    return select_impl<decltype(count)>(
+        q, n, d_data, d_selected, d_rejected, pred, d_num_selected,
+        d_workspace, dependences, workspace_ready);
+  });
+}
+
+} // namespace syclalgo::detail
+
+namespace syclalgo {
+
+template <typename T, typename Pred>
+auto copy_if(sycl::queue &q, size_t n, const T *d_data, T *d_out, Pred pred,
+             size_t *d_num_selected, std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::with_temporary_workspace(
+      q, select_workspace_size(q, n),
+      [&](void *d_workspace, sycl::event workspace_ready) {
+        return detail::select<T>(q, n, d_data, d_out, nullptr, pred,
+                                 d_num_selected, d_workspace, dependences,
+                                 workspace_ready);
+      });
+}
+
+template <typename T, typename Pred>
+auto copy_if(sycl::queue &q, size_t n, const T *d_data, T *d_out, Pred pred,
+             size_t *d_num_selected, void *d_workspace,
+             std::span<const sycl::event> dependences) -> sycl::event {
+  return detail::select<T>(q, n, d_data, d_out, nullptr, pred, d_num_selected,
+                           d_workspace, dependences);
+}
+
+template <typename T, typename Pred>
+auto remove_if(sycl::queue &q, size_t n, const T *d_data, T *d_out, Pred pred,
+               size_t *d_num_kept, std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return copy_if(
+      q, n, d_data, d_out, [=](const T &x) { return !pred(x); }, d_num_kept,
+      dependences);
+}
+
+template <typename T, typename Pred>
+auto remove_if(sycl::queue &q, size_t n, const T *d_data, T *d_out, Pred pred,
+               size_t *d_num_kept, void *d_workspace,
+               std::span<const sycl::event> dependences) -> sycl::event {
+  return copy_if(
+      q, n, d_data, d_out, [=](const T &x) { return !pred(x); }, d_num_kept,
+      d_workspace, dependences);
+}
+
+template <typename T, typename Pred>
+auto partition(sycl::queue &q, size_t n, const T *d_data, T *d_selected,
+               T *d_rejected, Pred pred, size_t *d_num_selected,
+               std::span<const sycl::event> dependences) -> sycl::event {
+  return detail::with_temporary_workspace(
+      q, select_workspace_size(q, n),
+      [&](void *d_workspace, sycl::event workspace_ready) {
+        return detail::select(q, n, d_data, d_selected, d_rejected, pred,
+                              d_num_selected, d_workspace, dependences,
+                              workspace_ready);
+      });
+}
+
+template <typename T, typename Pred>
+auto partition(sycl::queue &q, size_t n, const T *d_data, T *d_selected,
+               T *d_rejected, Pred pred, size_t *d_num_selected,
+               void *d_workspace, std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::select(q, n, d_data, d_selected, d_rejected, pred,
+                        d_num_selected, d_workspace, dependences);
+}
+
+template <typename T, typename Pred>
+auto count_if(sycl::queue &q, size_t n, const T *d_data, Pred pred,
+              size_t *d_count, std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return transform_reduce(
+      q, n, d_data, d_count, sycl::plus<size_t>(), 0,
+      [=](const T &x) { return size_t(pred(x)); }, dependences);
+}
+
+template <typename T, typename Pred>
+auto count_if(sycl::queue &q, size_t n, const T *d_data, Pred pred,
+              size_t *d_count, void *d_workspace,
+              std::span<const sycl::event> dependences) -> sycl::event {
+  return transform_reduce(
+      q, n, d_data, d_count, sycl::plus<size_t>(), 0,
+      [=](const T &x) { return size_t(pred(x)); }, d_workspace, dependences);
+}
+
+} // namespace syclalgo
@@ -0,0 +1,494 @@
+#pragma once
+#include "syclalgo-detail.hpp"
+#include "syclalgo-scan.hpp"
+#include "syclalgo.hpp"
+#include <algorithm>
+#include <type_traits>
+
+namespace syclalgo::detail {
+
+inline constexpr int RADIX_BITS = 8;
+inline constexpr int RADIX = 1 << RADIX_BITS;
+inline constexpr int SORT_BLOCK_SIZE = RADIX;
+inline constexpr int SORT_ELEMS = 8;
+inline constexpr int SORT_HISTOGRAM_ELEMS = 64;
+
+// Maps keys to unsigned bit patterns that order like the keys. Negative
+// floats have all bits flipped and the others their sign bit, so -0.0 sorts
+// before +0.0 and NaNs sort to the end of their sign.
+template <typename K> struct RadixKey {
+  static_assert(std::is_arithmetic_v<K> && (sizeof(K) == sizeof(uint32_t) ||
+                                            sizeof(K) == sizeof(uint64_t)),
+                "radix sort keys must be 32- or 64-bit numbers");
+
+  using Bits = std::conditional_t<sizeof(K) == sizeof(uint32_t), uint32_t,
+                                  uint64_t>;
+
+  static constexpr int NUM_PASSES = sizeof(K) * 8 / RADIX_BITS;
+  static constexpr Bits SIGN_BIT = Bits(1) << (sizeof(K) * 8 - 1);
+
+  static auto to_bits(K key) -> Bits {
+    Bits bits = sycl::bit_cast<Bits>(key);
+    if constexpr (std::is_floating_point_v<K>) {
+      return bits & SIGN_BIT ? ~bits : bits | SIGN_BIT;
+    } else if constexpr (std::is_signed_v<K>) {
+      return bits ^ SIGN_BIT;
+    } else {
+      return bits;
+    }
+  }
+
+  static auto from_bits(Bits bits) -> K {
+    if constexpr (std::is_floating_point_v<K>) {
+      bits = bits & SIGN_BIT ? bits ^ SIGN_BIT : ~bits;
+    } else if constexpr (std::is_signed_v<K>) {
+      bits ^= SIGN_BIT;
+    }
+    return sycl::bit_cast<K>(bits);
+  }
+
+  static auto digit(Bits bits, int shift) -> int {
+    return (bits >> shift) & (RADIX - 1);
+  }
+};
+
+// Values are carried through the sort unless V is void.
+template <typename V>
+using RadixValue = std::conditional_t<std::is_void_v<V>, std::byte, V>;
+
+inline auto radix_sort_num_groups(size_t n) -> size_t {
+  return ceil_div(n, SORT_BLOCK_SIZE * SORT_ELEMS);
+}
+
+// The workspace holds the alternate key and value buffers, the global digit
+// offsets of all passes, the partition descriptors of one pass and the
+// partition counter.
+template <typename K, typename V, typename CountT>
+struct RadixSortLayout {
+  size_t values_offset;
+  size_t offsets_offset;
+  size_t descriptors_offset;
+  size_t bid_offset;
+  size_t size;
+
+  explicit RadixSortLayout(size_t n) {
+    constexpr size_t VALUE_SIZE = std::is_void_v<V> ? 0 : sizeof(RadixValue<V>);
+    size_t num_descriptors = radix_sort_num_groups(n) * RADIX;
+    values_offset = align_up(sizeof(K) * n, alignof(RadixValue<V>));
+    offsets_offset = align_up(values_offset + VALUE_SIZE * n, alignof(CountT));
+    descriptors_offset = align_up(
+        offsets_offset + sizeof(CountT) * RadixKey<K>::NUM_PASSES * RADIX,
+        alignof(int64_t));
+    bid_offset = align_up(
+        descriptors_offset +
+            PartitionDescriptors<CountT>::storage_size(num_descriptors),
+        alignof(int));
+    size = bid_offset + sizeof(int);
+  }
+};
+
+template <typename K, typename V>
+auto radix_sort_scratch_size(size_t n) -> size_t {
+  return with_count_type(n, [&](auto count) {
+    return RadixSortLayout<K, V, decltype(count)>(n).size;
+  });
+}
+
+// Counts the digits of all passes in one read of the keys and turns the counts
+// into the exclusive offsets of each digit in the output of its pass.
+template <typename K, typename CountT>
+auto radix_sort_offsets(sycl::queue &q, size_t n, const K *d_keys,
+                        CountT *d_offsets,
+                        std::span<const sycl::event> dependences,
+                        sycl::event workspace_ready) -> sycl::event {
+  using Key = RadixKey<K>;
+  constexpr int BLOCK_SIZE = SORT_BLOCK_SIZE;
+  constexpr int ELEMS = SORT_HISTOGRAM_ELEMS;
+  constexpr int BLOCK_ELEMS = BLOCK_SIZE * ELEMS;
+  constexpr int NUM_COUNTERS = Key::NUM_PASSES * RADIX;
+
+  size_t counter_bytes = sizeof(CountT) * NUM_COUNTERS;
+  KernelLaunch counter_reset = {"radix sort counter reset", n, counter_bytes};
+  sycl::event e = submit_kernel(q, counter_reset, [&](sycl::handler &cg) {
+    depends_on(cg, dependences);
+    cg.depends_on(workspace_ready);
+    cg.parallel_for(sycl::range(NUM_COUNTERS),
+                    [=](sycl::item<1> id) { d_offsets[id] = 0; });
+  });
+
+  KernelLaunch histogram = {"radix sort histogram", n,
+                            sizeof(K) * n + counter_bytes};
+  e = submit_kernel(q, histogram, [&](sycl::handler &cg) {
+    sycl::local_accessor<int> hist_shm(NUM_COUNTERS, cg);
+
+    cg.depends_on(e);
+    depends_on(cg, dependences);
+
+    size_t num_groups = ceil_div(n, BLOCK_ELEMS);
+    sycl::nd_range<1> range = {num_groups * BLOCK_SIZE, BLOCK_SIZE};
+    cg.parallel_for(range, [=](sycl::nd_item<1> id) {
+      auto g = id.get_group();
+      int lid = id.get_local_id();
+      size_t bid = g.get_group_id();
+
+      for (int i = lid; i < NUM_COUNTERS; i += BLOCK_SIZE) {
+        hist_shm[i] = 0;
+      }
+      sycl::group_barrier(g);
+
+      for (int i = 0; i < ELEMS; ++i) {
+        size_t gidx = bid * BLOCK_ELEMS + i * BLOCK_SIZE + lid;
+        if (gidx < n) {
+          auto bits = Key::to_bits(d_keys[gidx]);
+          for (int pass = 0; pass < Key::NUM_PASSES; ++pass) {
+            int digit = Key::digit(bits, pass * RADIX_BITS);
+            sycl::atomic_ref<int, sycl::memory_order_relaxed,
+                             sycl::memory_scope::work_group,
+                             sycl::access::address_space::local_space>
+                counter_ref(hist_shm[pass * RADIX + digit]);
+            counter_ref.fetch_add(1);
+          }
+        }
+      }
+      sycl::group_barrier(g);
+
+      for (int i = lid; i < NUM_COUNTERS; i += BLOCK_SIZE) {
+        if (hist_shm[i] != 0) {
+          sycl::atomic_ref<CountT, sycl::memory_order_relaxed,
+                           sycl::memory_scope::device,
+                           sycl::access::address_space::global_space>
+              offset_ref(d_offsets[i]);
+          offset_ref.fetch_add(hist_shm[i]);
+        }
+      }
+    });
+  });
+
+  KernelLaunch offsets = {"radix sort offsets", n, 2 * counter_bytes};
+  return submit_kernel(q, offsets, [&](sycl::handler &cg) {
+    sycl::local_accessor<CountT> scan_shm(
+        group_inclusive_scan_shm_size(RADIX), cg);
+
+    cg.depends_on(e);
+
+    sycl::nd_range<1> range = {NUM_COUNTERS, RADIX};
+    cg.parallel_for(range, [=](sycl::nd_item<1> id) {
+      int lid = id.get_local_id();
+      size_t gid = id.get_global_id();
+
+      CountT count = d_offsets[gid];
+      scan_shm[lid] = count;
+
+      group_inclusive_scan<RADIX, 1, CountT>(id, scan_shm,
+                                             sycl::plus<CountT>());
+
+      d_offsets[gid] = scan_shm[lid] - count;
+    });
+  });
+}
+
+// One digit-binning pass. Every work-group counts the digits of its partition
+// and looks back for the offsets of its digits, with one look-back chain per
+// digit. It then sorts the partition by digit in local memory and writes each
+// run of equal digits to its offset. On devices without forward progress, the
+// digits of every partition are counted and scanned first into
+// d_block_offsets, which takes the place of the descriptors, and the pass
+// reads the offsets instead of looking back.
+template <typename K, typename V, typename CountT>
+auto radix_sort_pass(sycl::queue &q, size_t n, int shift, const K *d_keys,
+                     K *d_keys_out, const RadixValue<V> *d_values,
+                     RadixValue<V> *d_values_out, const CountT *d_offsets,
+                     PartitionDescriptors<CountT> descriptors,
+                     CountT *d_block_offsets, int *d_bid, sycl::event e)
+    -> sycl::event {
+  using Key = RadixKey<K>;
+  using Bits = typename Key::Bits;
+  using Value = RadixValue<V>;
+  constexpr bool HAS_VALUES = !std::is_void_v<V>;
+  constexpr int BLOCK_SIZE = SORT_BLOCK_SIZE;
+  constexpr int ELEMS = SORT_ELEMS;
+  constexpr int BLOCK_ELEMS = BLOCK_SIZE * ELEMS;
+  static_assert(BLOCK_SIZE == RADIX, "every work-item owns one digit");
+
+  size_t num_groups = radix_sort_num_groups(n);
+  bool use_look_back = has_forward_progress(get_device_info(q.get_device()));
+
+  if (use_look_back) {
+    e = reset_partitions(q, n, descriptors, d_bid, num_groups * RADIX, {&e, 1},
+                         {});
+  } else {
+    size_t block_offset_bytes = sizeof(CountT) * num_groups * RADIX;
+    KernelLaunch count = {"radix sort block counts", n,
+                          sizeof(K) * n + block_offset_bytes,
+                          shift / RADIX_BITS};
+    e = submit_kernel(q, count, [&](sycl::handler &cg) {
+      sycl::local_accessor<int> hist_shm(RADIX, cg);
+
+      cg.depends_on(e);
+
+      sycl::nd_range<1> range = {num_groups * BLOCK_SIZE, BLOCK_SIZE};
+      cg.parallel_for(range, [=](sycl::nd_item<1> id) {
+        auto g = id.get_group();
+        int lid = id.get_local_id();
+        size_t bid = g.get_group_id();
+        size_t thread_offset = bid * BLOCK_ELEMS + lid * ELEMS;
+
+        hist_shm[lid] = 0;
+        sycl::group_barrier(g);
+
+        for (int i = 0; i < ELEMS && thread_offset + i < n; ++i) {
+          Bits bits = Key::to_bits(d_keys[thread_offset + i]);
+          sycl::atomic_ref<int, sycl::memory_order_relaxed,
+                           sycl::memory_scope::work_group,
+                           sycl::access::address_space::local_space>
+              counter_ref(hist_shm[Key::digit(bits, shift)]);
+          counter_ref.fetch_add(1);
+        }
+        sycl::group_barrier(g);
+
+        // Laid out like the look-back chains, one row of partitions per digit.
+        d_block_offsets[lid * num_groups + bid] = hist_shm[lid];
+      });
+    });
+
+    KernelLaunch scan_counts = {"radix sort block count scan", n,
+                                2 * block_offset_bytes, shift / RADIX_BITS};
+    e = scan_tile_sums<BLOCK_SIZE>(q, scan_counts, d_block_offsets, RADIX,
+                                   num_groups, sycl::plus<CountT>(), CountT(0),
+                                   [](size_t, CountT) {}, e);
+  }
+
+  size_t value_bytes = HAS_VALUES ? sizeof(Value) : 0;
+  KernelLaunch pass = {"radix sort pass", n,
+                       2 * (sizeof(K) + value_bytes) * n,
+                       shift / RADIX_BITS};
+  return submit_kernel(q, pass, [&](sycl::handler &cg) {
+    sycl::local_accessor<Bits> key_shm(BLOCK_ELEMS, cg);
+    sycl::local_accessor<Value> value_shm(HAS_VALUES ? BLOCK_ELEMS : 1, cg);
+    sycl::local_accessor<int> scan_shm(
+        group_inclusive_scan_shm_size(BLOCK_SIZE), cg);
+    sycl::local_accessor<int> hist_shm(RADIX, cg);
+    sycl::local_accessor<CountT> offset_shm(RADIX, cg);
+    sycl::local_accessor<int> bid_shm(1, cg);
+
+    cg.depends_on(e);
+
+    sycl::nd_range<1> range = {num_groups * BLOCK_SIZE, BLOCK_SIZE};
+    cg.parallel_for(range, [=](sycl::nd_item<1> id) {
+      auto g = id.get_group();
+      int lid = id.get_local_id();
+
+      int bid = use_look_back ? next_partition(id, d_bid, bid_shm, num_groups)
+                              : int(g.get_group_id());
+
+      size_t block_offset = size_t(bid) * BLOCK_ELEMS;
+      size_t thread_offset = block_offset + lid * ELEMS;
+
+      // Missing keys get the largest digit and stay behind the others.
+      Bits keys[ELEMS];
+      Value values[ELEMS];
+      for (int i = 0; i < ELEMS; ++i) {
+        size_t gidx = thread_offset + i;
+        keys[i] = ~Bits(0);
+        if (gidx < n) {
+          keys[i] = Key::to_bits(d_keys[gidx]);
+          if constexpr (HAS_VALUES) {
+            values[i] = d_values[gidx];
+          }
+        }
+      }
+
+      hist_shm[lid] = 0;
+      sycl::group_barrier(g);
+
+      for (int i = 0; i < ELEMS; ++i) {
+        if (thread_offset + i < n) {
+          sycl::atomic_ref<int, sycl::memory_order_relaxed,
+                           sycl::memory_scope::work_group,
+                           sycl::access::address_space::local_space>
+              counter_ref(hist_shm[Key::digit(keys[i], shift)]);
+          counter_ref.fetch_add(1);
+        }
+      }
+      sycl::group_barrier(g);
+
+      int count = hist_shm[lid];
+      scan_shm[lid] = count;
+
+      group_inclusive_scan<BLOCK_SIZE, 1, int>(id, scan_shm, sycl::plus<int>());
+
+      // Offsets wrap around in unsigned arithmetic and are only used once the
+      // position in the block, which is at least the start of the digit, has
+      // been added.
+      int digit_start = scan_shm[lid] - count;
+      size_t pid = lid * num_groups + bid;
+      CountT prefix = use_look_back
+                          ? look_back(descriptors, pid, bid == 0, CountT(count),
+                                      sycl::plus<CountT>(), CountT(0))
+                          : d_block_offsets[pid];
+      offset_shm[lid] = d_offsets[lid] + prefix - CountT(digit_start);
+      sycl::group_barrier(g);
+
+      // Stable sort of the partition by the digit, one bit at a time.
+      for (int bit = 0; bit < RADIX_BITS; ++bit) {
+        int zeros = 0;
+        for (int i = 0; i < ELEMS; ++i) {
+          zeros += !((keys[i] >> (shift + bit)) & 1);
+        }
+        scan_shm[lid] = zeros;
+
+        group_inclusive_scan<BLOCK_SIZE, 1, int>(id, scan_shm,
+                                                 sycl::plus<int>());
+
+        int zero_pos = scan_shm[lid] - zeros;
+        int one_pos = scan_shm[BLOCK_SIZE - 1] + lid * ELEMS - zero_pos;
+        for (int i = 0; i < ELEMS; ++i) {
+          int pos = (keys[i] >> (shift + bit)) & 1 ? one_pos++ : zero_pos++;
+          key_shm[pos] = keys[i];
+          if constexpr (HAS_VALUES) {
+            value_shm[pos] = values[i];
+          }
+        }
+        sycl::group_barrier(g);
+
+        if (bit == RADIX_BITS - 1) {
+          break;
+        }
+        for (int i = 0; i < ELEMS; ++i) {
+          keys[i] = key_shm[lid * ELEMS + i];
+          if constexpr (HAS_VALUES) {
+            values[i] = value_shm[lid * ELEMS + i];
+          }
+        }
+        sycl::group_barrier(g);
+      }
+
+      size_t block_elems = std::min<size_t>(BLOCK_ELEMS, n - block_offset);
+      for (size_t j = lid; j < block_elems; j += BLOCK_SIZE) {
+        Bits bits = key_shm[j];
+        size_t gidx = CountT(offset_shm[Key::digit(bits, shift)] + CountT(j));
+        d_keys_out[gidx] = Key::from_bits(bits);
+        if constexpr (HAS_VALUES) {
+          d_values_out[gidx] = value_shm[j];
+        }
+      }
+    });
+  });
+}
+
+template <typename K, typename V, typename CountT>
+auto radix_sort_impl(sycl::queue &q, size_t n, const K *d_keys, K *d_keys_out,
+                     const RadixValue<V> *d_values,
+                     RadixValue<V> *d_values_out, void *d_workspace,
+                     std::span<const sycl::event> dependences,
+                     sycl::event workspace_ready) -> sycl::event {
+  constexpr int NUM_PASSES = RadixKey<K>::NUM_PASSES;
+  static_assert(NUM_PASSES % 2 == 0, "the last pass must write d_keys_out");
+
+  if (n == 0) {
+    return {};
+  }
+
+  RadixSortLayout<K, V, CountT> layout(n);
+  auto *d_bytes = static_cast<std::byte *>(d_workspace);
+  auto *d_alt_keys = reinterpret_cast<K *>(d_bytes);
+  auto *d_alt_values =
+      reinterpret_cast<RadixValue<V> *>(d_bytes + layout.values_offset);
+  auto *d_offsets = reinterpret_cast<CountT *>(d_bytes + layout.offsets_offset);
+  PartitionDescriptors<CountT> descriptors(
+      d_bytes + layout.descriptors_offset, radix_sort_num_groups(n) * RADIX);
+  auto *d_block_offsets =
+      reinterpret_cast<CountT *>(d_bytes + layout.descriptors_offset);
+  auto *d_bid = reinterpret_cast<int *>(d_bytes + layout.bid_offset);
+
+  sycl::event e = radix_sort_offsets(q, n, d_keys, d_offsets, dependences,
+                                     workspace_ready);
+
+  // Passes alternate between the workspace and the output, starting with the
+  // workspace, so the input is only read by the first pass.
+  for (int pass = 0; pass < NUM_PASSES; ++pass) {
+    bool to_output = pass % 2 == 1;
+    K *d_keys_dst = to_output ? d_keys_out : d_alt_keys;
+    RadixValue<V> *d_values_dst = to_output ? d_values_out : d_alt_values;
+    e = radix_sort_pass<K, V>(q, n, pass * RADIX_BITS, d_keys, d_keys_dst,
+                              d_values, d_values_dst, d_offsets + pass * RADIX,
+                              descriptors, d_block_offsets, d_bid, e);
+    d_keys = d_keys_dst;
+    d_values = d_values_dst;
+  }
+
+  return e;
+}
+
+template <typename K, typename V>
+auto radix_sort(sycl::queue &q, size_t n, const K *d_keys, K *d_keys_out,
+                const RadixValue<V> *d_values, RadixValue<V> *d_values_out,
+                void *d_workspace,
+                std::span<const sycl::event> dependences = {},
+                sycl::event workspace_ready = {}) -> sycl::event {
+  return with_count_type(n, [&](auto count) {
+    return radix_sort_impl<K, V, decltype(count)>(
+        q, n, d_keys, d_keys_out, d_values, d_values_out, d_workspace,
+        dependences, workspace_ready);
+  });
+}
+
+} // namespace syclalgo::detail
+
+namespace syclalgo {
+
+template <typename K>
+auto radix_sort_keys_workspace_size(sycl::queue &, size_t n) -> size_t {
+  return detail::radix_sort_scratch_size<K, void>(n);
+}
+
+template <typename K, typename V>
+auto radix_sort_pairs_workspace_size(sycl::queue &, size_t n) -> size_t {
+  return detail::radix_sort_scratch_size<K, V>(n);
+}
+
+template <typename K>
+auto radix_sort_keys(sycl::queue &q, size_t n, const K *d_keys, K *d_keys_out,
+                     std::span<const sycl::event> dependences) -> sycl::event {
+  return detail::with_temporary_workspace(
+      q, radix_sort_keys_workspace_size<K>(q, n),
+      [&](void *d_workspace, sycl::event workspace_ready) {
+        return detail::radix_sort<K, void>(q, n, d_keys, d_keys_out, nullptr,
+                                           nullptr, d_workspace, dependences,
+                                           workspace_ready);
+      });
+}
+
+template <typename K>
+auto radix_sort_keys(sycl::queue &q, size_t n, const K *d_keys, K *d_keys_out,
+                     void *d_workspace,
+                     std::span<const sycl::event> dependences) -> sycl::event {
+  return detail::radix_sort<K, void>(q, n, d_keys, d_keys_out, nullptr,
+                                     nullptr, d_workspace, dependences);
+}
+
+template <typename K, typename V>
+auto radix_sort_pairs(sycl::queue &q, size_t n, const K *d_keys,
+                      K *d_keys_out, const V *d_values, V *d_values_out,
+                      std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::with_temporary_workspace(
+      q, radix_sort_pairs_workspace_size<K, V>(q, n),
+      [&](void *d_workspace, sycl::event workspace_ready) {
+        return detail::radix_sort<K, V>(q, n, d_keys, d_keys_out, d_values,
+                                        d_values_out, d_workspace, dependences,
+                                        workspace_ready);
+      });
+}
+
+template <typename K, typename V>
+auto radix_sort_pairs(sycl::queue &q, size_t n, const K *d_keys,
+                      K *d_keys_out, const V *d_values, V *d_values_out,
+                      void *d_workspace,
+                      std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return detail::radix_sort<K, V>(q, n, d_keys, d_keys_out, d_values,
+                                  d_values_out, d_workspace, dependences);
+}
+
+} // namespace syclalgo
@@ -0,0 +1,140 @@
+// Measures every instantiated scan kernel on the default device for a range of
+// input sizes and records the fastest one per size in the tuning file, which
+// the library reads the first time it uses the device.
+//
+// Usage: syclalgo-tune [tuning file [max n]]
+#include "syclalgo.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+namespace {
+
+using syclalgo::detail::ScanAlgorithm;
+using syclalgo::detail::ScanChoice;
+using syclalgo::detail::ScanConfig;
+using syclalgo::detail::ScanTuning;
+
+constexpr size_t MIN_N = size_t(1) << 10;
+constexpr size_t DEFAULT_MAX_N = size_t(1) << 26;
+constexpr int N_STEP = 4;
+constexpr int NUM_RUNS = 10;
+
+// Mean time of an exclusive int sum of n ones, or infinity if the result is
+// wrong.
+auto time_scan(sycl::queue &q, ScanChoice choice, size_t n, const int *d_data,
+               int *d_out) -> double {
+  size_t workspace_size =
+      syclalgo::detail::scan_scratch_size<int>(q.get_device(), choice, n);
+  void *d_workspace =
+      workspace_size > 0 ? sycl::malloc_device(workspace_size, q) : nullptr;
+
+  auto run = [&] {
+    syclalgo::detail::scan<syclalgo::detail::ScanType::Exclusive>(
+        q, choice, n, d_data, d_out, sycl::plus<int>(), 0, {0}, d_workspace);
+  };
+
+  run();
+  int last = 0;
+  q.copy(d_out + n - 1, &last, 1).wait();
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < NUM_RUNS; ++i) {
+    run();
+  }
+  q.wait();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  sycl::free(d_workspace, q);
+
+  if (size_t(last) != n - 1) {
+    return std::numeric_limits<double>::infinity();
+  }
+  return elapsed.count() / NUM_RUNS;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::filesystem::path path =
+      argc > 1 ? argv[1] : syclalgo::detail::scan_tuning_path();
+  size_t max_n = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : DEFAULT_MAX_N;
+  if (path.empty() || max_n < MIN_N) {
+    std::fprintf(stderr, "usage: %s [tuning file [max n]]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  sycl::queue q{sycl::property::queue::in_order()};
+  sycl::device dev = q.get_device();
+  const auto &info = syclalgo::detail::get_device_info(dev);
+  std::string device_name = dev.get_info<sycl::info::device::name>();
+  std::string driver_version =
+      dev.get_info<sycl::info::device::driver_version>();
+
+  std::printf("%s (driver %s)\n", device_name.c_str(), driver_version.c_str());
+
+  std::vector<int> data(max_n, 1);
+  int *d_data = sycl::malloc_device<int>(max_n, q);
+  int *d_out = sycl::malloc_device<int>(max_n, q);
+  q.copy(data.data(), d_data, max_n).wait();
+
+  // Each size is tuned for the inputs above the previous size and the last
+  // one for all larger inputs.
+  std::vector<ScanTuning> tunings;
+  for (size_t n = MIN_N; n <= max_n; n *= N_STEP) {
+    ScanChoice best = {};
+    double best_time = std::numeric_limits<double>::infinity();
+    for (ScanAlgorithm algorithm : syclalgo::detail::SCAN_ALGORITHMS) {
+      if (!syclalgo::detail::scan_allowed(info, algorithm)) {
+        continue;
+      }
+      if (algorithm == ScanAlgorithm::SingleGroup &&
+          n > syclalgo::detail::SINGLE_GROUP_SCAN_MAX_N) {
+        continue;
+      }
+      for (ScanConfig config : syclalgo::detail::scan_configs(algorithm)) {
+        if (!syclalgo::detail::scan_fits<int>(dev, algorithm, config)) {
+          continue;
+        }
+        double time = time_scan(q, {algorithm, config}, n, d_data, d_out);
+        if (time < best_time) {
+          best = {algorithm, config};
+          best_time = time;
+        }
+      }
+    }
+    if (best_time == std::numeric_limits<double>::infinity()) {
+      continue;
+    }
+
+    std::printf(
+        "%12zu %-16s %5d %4d %-10s %12.1f us\n", n,
+        syclalgo::detail::scan_algorithm_name(best.algorithm).data(),
+        best.config.block_size, best.config.elems,
+        syclalgo::detail::group_scan_algorithm_name(best.config.group_scan)
+            .data(),
+        best_time * 1e6);
+    tunings.push_back({device_name, driver_version, n, best});
+  }
+  if (!tunings.empty()) {
+    tunings.back().max_n = SIZE_MAX;
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_out, q);
+
+  // Tunings of other devices and drivers are kept.
+  std::vector<ScanTuning> merged = syclalgo::detail::read_scan_tuning(path);
+  std::erase_if(merged, [&](const ScanTuning &tuning) {
+    return tuning.device_name == device_name &&
+           tuning.driver_version == driver_version;
+  });
+  merged.insert(merged.end(), tunings.begin(), tunings.end());
+  syclalgo::detail::write_scan_tuning(path, merged);
+
+  std::printf("Wrote %s\n", path.string().c_str());
+  return EXIT_SUCCESS;
+}
@@ -1,540 +1,1057 @@
 #include "syclalgo.hpp"
-#include <thread>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
 
 namespace syclalgo {
 
 namespace {
 
-void depends_on(sycl::handler &cg, std::span<const sycl::event> dependences) {
-  static thread_local std::vector<sycl::event> kernel_dependences;
-  kernel_dependences.assign(dependences.begin(), dependences.end());
-  cg.depends_on(kernel_dependences);
-  kernel_dependences.clear();
-}
+class MemoryPool {
+public:
+  MemoryPool(sycl::context ctx, sycl::device dev)
+      : ctx(std::move(ctx)), dev(std::move(dev)) {}
 
-constexpr auto ceil_div(size_t num, size_t denom) -> size_t {
-  return num / denom + (num % denom != 0);
-}
+  // Returns a block of at least `bytes` bytes and an event that work using the
+  // block must depend on.
+  auto allocate(size_t bytes) -> std::pair<void *, sycl::event> {
+    if (bytes == 0) {
+      return {};
+    }
 
-} // namespace
+    int bin = size_class(bytes);
+    FreeBlock block = take_block(bin);
 
-namespace {
+    std::lock_guard lock(mutex);
+    live.emplace(block.ptr, bin);
+    count_in_use_locked(bin);
+    return {block.ptr, block.release};
+  }
 
-template <typename T>
-auto axpy(sycl::queue &q, size_t n, T alpha, const T *d_x, T *d_y,
-          std::span<const sycl::event> dependences = {}) -> sycl::event {
-  if (n == 0) {
-    return {};
+  // Returns a block of at least `bytes` bytes kept for calls with `layout`,
+  // as the last call with `layout` left it if possible and zeroed otherwise.
+  // The call reads its first `tag_bytes` bytes as counters and epoch-tagged
+  // words, so the block is zeroed if earlier calls left other data there.
+  // Zeroing is submitted to `q`.
+  auto acquire_reused(sycl::queue &q, detail::WorkspaceLayout layout,
+                      size_t bytes, size_t tag_bytes)
+      -> detail::ReusedWorkspace {
+    if (bytes == 0) {
+      return {};
+    }
+
+    int bin = size_class(bytes);
+
+    std::optional<ReusedBlock> reused_block = take_reused(layout, bin);
+    ReusedBlock block;
+    if (reused_block) {
+      block = *reused_block;
+    } else {
+      FreeBlock free_block = take_block(bin);
+      block = {free_block.ptr, bin, layout, detail::MAX_WORKSPACE_EPOCH,
+               free_block.release};
+    }
+
+    if (block.layout != layout || block.epoch == detail::MAX_WORKSPACE_EPOCH ||
+        tag_bytes > block.tag_bytes) {
+      detail::KernelLaunch clear = {"workspace clear", 0,
+                                    size_t(1) << block.bin};
+      block.release = detail::submit_kernel(q, clear, [&](sycl::handler &cg) {
+        cg.depends_on(block.release);
+        cg.memset(block.ptr, 0, size_t(1) << block.bin);
+      });
+      block.layout = layout;
+      block.epoch = 0;
+    }
+    block.epoch++;
+    // Past its tags the call may leave any data.
+    block.tag_bytes = tag_bytes;
+
+    std::lock_guard lock(mutex);
+    reused_live.emplace(block.ptr, block);
+    count_in_use_locked(block.bin);
+    return {block.ptr, block.release, block.epoch};
   }
 
-  return q.submit([&](sycl::handler &cg) {
-    depends_on(cg, dependences);
-    cg.parallel_for(
-        n, [=](sycl::id<1> idx) { d_y[idx] = alpha * d_x[idx] + d_y[idx]; });
-  });
-}
+  // Returns a block to the pool. The block is not reused before `release`
+  // completes. Pointers that the pool did not hand out, or that were already
+  // returned, are ignored.
+  void deallocate(void *ptr, sycl::event release) {
+    if (!ptr) {
+      return;
+    }
 
-} // namespace
+    std::lock_guard lock(mutex);
 
-auto saxpy(sycl::queue &q, size_t n, float alpha, const float *d_x, float *d_y,
-           std::span<const sycl::event> dependences) -> sycl::event {
-  return axpy(q, n, alpha, d_x, d_y, dependences);
-}
+    auto it = live.find(ptr);
+    if (it == live.end()) {
+      return;
+    }
+    int bin = it->second;
+    live.erase(it);
 
-namespace {
+    size_t block_size = size_t(1) << bin;
+    stats.bytes_in_use -= block_size;
+    stats.bytes_cached += block_size;
 
-enum class ScanType {
-  Exclusive,
-  Inclusive,
-};
+    bins[bin].push_back({ptr, std::move(release)});
+  }
 
-template <int BLOCK_SIZE, int ELEMS>
-void group_inclusive_scan(sycl::group<1> g, sycl::local_ptr<int> shm) {
-  constexpr int BLOCK_ELEMS = BLOCK_SIZE * ELEMS;
+  // Keeps a reused block for the next call with its layout. The block is not
+  // reused before `release` completes.
+  void release_reused(void *ptr, sycl::event release) {
+    if (!ptr) {
+      return;
+    }
 
-  int lid = g.get_local_id();
+    std::lock_guard lock(mutex);
 
-  for (int stride = 1; stride < BLOCK_SIZE; stride *= 2) {
-    for (int i = 0; i < ELEMS; ++i) {
-      int dst = BLOCK_ELEMS - (i * BLOCK_SIZE + lid) - 1;
-      int src = dst - stride;
-      int dst_value, src_value;
-      if (src >= 0) {
-        dst_value = shm[dst];
-        src_value = shm[src];
-      }
-      sycl::group_barrier(g);
-      if (src >= 0) {
-        shm[dst] = src_value + dst_value;
-      }
+    auto node = reused_live.extract(ptr);
+    if (node.empty()) {
+      return;
     }
-    sycl::group_barrier(g);
+    ReusedBlock &block = node.mapped();
+    block.release = std::move(release);
+
+    size_t block_size = size_t(1) << block.bin;
+    stats.bytes_in_use -= block_size;
+    stats.bytes_cached += block_size;
+
+    reused.push_back(std::move(block));
   }
 
-  for (int stride = BLOCK_SIZE; stride < BLOCK_ELEMS; stride *= 2) {
-    for (int i = 0; i < ELEMS; ++i) {
-      int dst = BLOCK_ELEMS - (i * BLOCK_SIZE + lid) - 1;
-      int src = dst - stride;
-      if (src >= 0) {
-        shm[dst] += shm[src];
+  // Frees all cached blocks. Their releases are waited for without holding
+  // the lock, so that other calls keep allocating meanwhile.
+  void trim() {
+    std::vector<FreeBlock> blocks;
+    {
+      std::lock_guard lock(mutex);
+      for (int bin = 0; bin < NUM_BINS; ++bin) {
+        for (FreeBlock &block : bins[bin]) {
+          blocks.push_back(std::move(block));
+          stats.bytes_cached -= size_t(1) << bin;
+        }
+        bins[bin].clear();
+      }
+      for (ReusedBlock &block : reused) {
+        blocks.push_back({block.ptr, std::move(block.release)});
+        stats.bytes_cached -= size_t(1) << block.bin;
       }
+      reused.clear();
+    }
+
+    for (FreeBlock &block : blocks) {
+      block.release.wait();
+      sycl::free(block.ptr, ctx);
     }
-    sycl::group_barrier(g);
   }
-}
 
-template <ScanType ST, int BLOCK_SIZE, int ELEMS>
-auto recursive_scan_impl(sycl::queue &q, int n, const int *d_data, int *d_out,
-                         int *d_scratch,
-                         std::span<const sycl::event> dependences = {})
-    -> sycl::event {
-  constexpr int BLOCK_ELEMS = BLOCK_SIZE * ELEMS;
+  auto get_stats() -> PoolStats {
+    std::lock_guard lock(mutex);
+    return stats;
+  }
 
-  int num_groups = ceil_div(n, BLOCK_ELEMS);
-  sycl::nd_range<1> range = {num_groups * BLOCK_SIZE, BLOCK_SIZE};
+private:
+  static constexpr int MIN_BIN = 8;
+  static constexpr int NUM_BINS = std::numeric_limits<size_t>::digits;
 
-  int *d_block_sum = num_groups > 1 ? d_scratch : nullptr;
+  struct FreeBlock {
+    void *ptr;
+    sycl::event release;
+  };
 
-  sycl::event e = q.submit([&](sycl::handler &cg) {
-    sycl::local_accessor<int> shm(BLOCK_ELEMS, cg);
+  struct ReusedBlock {
+    void *ptr = nullptr;
+    int bin = 0;
+    detail::WorkspaceLayout layout = {};
+    uint32_t epoch = 0;
+    sycl::event release;
+    // Leading bytes that held only counters and tags since the last zeroing.
+    size_t tag_bytes = 0;
+  };
 
-    depends_on(cg, dependences);
+  static auto size_class(size_t bytes) -> int {
+    return std::max<int>(std::bit_width(bytes - 1), MIN_BIN);
+  }
 
-    cg.parallel_for(range, [=](sycl::nd_item<1> id) {
-      auto g = id.get_group();
-      int lid = g.get_local_id();
-      int bid = g.get_group_id();
+  // Takes a kept block of size class `bin` or more, preferring one last used
+  // with `layout`. If there is none, blocks too small for the call serve as
+  // temporary blocks from now on.
+  auto take_reused(detail::WorkspaceLayout layout, int bin)
+      -> std::optional<ReusedBlock> {
+    std::lock_guard lock(mutex);
+
+    auto fits = [&](const ReusedBlock &block) { return block.bin >= bin; };
+    auto it = std::find_if(reused.begin(), reused.end(),
+                           [&](const ReusedBlock &block) {
+                             return block.layout == layout && fits(block);
+                           });
+    if (it == reused.end()) {
+      it = std::find_if(reused.begin(), reused.end(), fits);
+    }
 
-      for (int i = 0; i < ELEMS; ++i) {
-        int lidx = i * BLOCK_SIZE + lid;
-        int gidx = bid * BLOCK_ELEMS + lidx;
-        if constexpr (ST == ScanType::Exclusive) {
-          gidx--;
-          shm[lidx] = gidx >= 0 && gidx < n ? d_data[gidx] : 0;
-        } else if constexpr (ST == ScanType::Inclusive) {
-          shm[lidx] = gidx < n ? d_data[gidx] : 0;
+    if (it == reused.end()) {
+      std::erase_if(reused, [&](const ReusedBlock &small) {
+        if (small.layout != layout) {
+          return false;
         }
-      }
-      sycl::group_barrier(g);
+        bins[small.bin].push_back({small.ptr, small.release});
+        return true;
+      });
+      return std::nullopt;
+    }
 
-      group_inclusive_scan<BLOCK_SIZE, ELEMS>(g, shm);
+    ReusedBlock block = *it;
+    reused.erase(it);
+    stats.bytes_cached -= size_t(1) << block.bin;
+    stats.num_cache_hits++;
+    return block;
+  }
 
-      for (int i = 0; i < ELEMS; ++i) {
-        int lidx = i * BLOCK_SIZE + lid;
-        int gidx = bid * BLOCK_ELEMS + lidx;
-        if (gidx < n) {
-          d_out[gidx] = shm[lidx];
-        }
+  // Takes a free block of size class `bin` or allocates one. Allocation
+  // happens without holding the lock.
+  auto take_block(int bin) -> FreeBlock {
+    size_t block_size = size_t(1) << bin;
+
+    {
+      std::lock_guard lock(mutex);
+      auto &free_blocks = bins[bin];
+      if (!free_blocks.empty()) {
+        FreeBlock block = std::move(free_blocks.back());
+        free_blocks.pop_back();
+        stats.bytes_cached -= block_size;
+        stats.num_cache_hits++;
+        return block;
       }
+    }
 
-      if (d_block_sum && g.leader()) {
-        d_block_sum[bid] = shm[BLOCK_ELEMS - 1];
-      }
-    });
-  });
+    void *ptr = sycl::malloc_device(block_size, dev, ctx);
+    if (!ptr) {
+      trim();
+      ptr = sycl::malloc_device(block_size, dev, ctx);
+    }
+    if (!ptr) {
+      throw std::bad_alloc();
+    }
 
-  if (!d_block_sum) {
-    return e;
+    std::lock_guard lock(mutex);
+    stats.num_device_allocations++;
+    return {ptr, {}};
   }
 
-  e = recursive_scan_impl<ScanType::Exclusive, BLOCK_SIZE, ELEMS>(
-      q, num_groups, d_block_sum, d_block_sum, d_scratch + num_groups, {&e, 1});
-
-  return q.submit([&](sycl::handler &cg) {
-    cg.depends_on(e);
-    cg.parallel_for(range, [=](sycl::nd_item<1> id) {
-      auto g = id.get_group();
-      int lid = id.get_local_id();
-      int bid = g.get_group_id();
-      for (int i = 0; i < ELEMS; ++i) {
-        int lidx = i * BLOCK_SIZE + lid;
-        int gidx = bid * BLOCK_ELEMS + lidx;
-        if (gidx < n) {
-          d_out[gidx] += d_block_sum[bid];
-        }
-      }
-    });
-  });
-}
+  void count_in_use_locked(int bin) {
+    stats.bytes_in_use += size_t(1) << bin;
+    stats.bytes_high_water = std::max(stats.bytes_high_water,
+                                      stats.bytes_in_use + stats.bytes_cached);
+  }
 
-template <ScanType ST>
-auto recursive_scan(sycl::queue &q, size_t n, const int *d_data, int *d_out,
-                    std::span<const sycl::event> dependences = {})
-    -> sycl::event {
-  constexpr int BLOCK_SIZE = 64;
-  constexpr int ELEMS = 8;
-  constexpr int BLOCK_ELEMS = BLOCK_SIZE * ELEMS;
+  sycl::context ctx;
+  sycl::device dev;
+  std::mutex mutex;
+  std::array<std::vector<FreeBlock>, NUM_BINS> bins;
+  std::unordered_map<void *, int> live;
+  std::vector<ReusedBlock> reused;
+  std::unordered_map<void *, ReusedBlock> reused_live;
+  PoolStats stats;
+};
 
-  if (n == 0) {
-    return {};
-  }
+// Queues on the same device and context share a pool, so that the pools stay
+// as many as the devices and contexts in use, however many queues come and go.
+struct PoolKey {
+  sycl::context ctx;
+  sycl::device dev;
 
-  size_t scratch_cnt = 0;
-  size_t num_groups = n;
-  do {
-    num_groups = ceil_div(num_groups, BLOCK_ELEMS);
-    scratch_cnt += num_groups;
-  } while (num_groups > 1);
+  auto operator==(const PoolKey &) const -> bool = default;
+};
 
-  int *d_scratch =
-      scratch_cnt > 1 ? sycl::malloc_device<int>(scratch_cnt, q) : nullptr;
+struct PoolKeyHash {
+  auto operator()(const PoolKey &key) const -> size_t {
+    size_t h = std::hash<sycl::context>()(key.ctx);
+    return h ^ (std::hash<sycl::device>()(key.dev) + 0x9e3779b9 + (h << 6) +
+                (h >> 2));
+  }
+};
 
-  sycl::event e = recursive_scan_impl<ST, BLOCK_SIZE, ELEMS>(
-      q, n, d_data, d_out, d_scratch, dependences);
+auto get_pool(sycl::queue &q) -> MemoryPool & {
+  static std::mutex mutex;
+  // Never destroyed: freeing USM from static destructors races with the SYCL
+  // runtime's own shutdown.
+  static auto *pools =
+      new std::unordered_map<PoolKey, std::unique_ptr<MemoryPool>,
+                             PoolKeyHash>();
 
-  std::thread([q, e, d_scratch]() mutable {
-    e.wait();
-    sycl::free(d_scratch, q);
-  }).detach();
+  PoolKey key = {q.get_context(), q.get_device()};
 
-  return e;
+  std::lock_guard lock(mutex);
+  auto &pool = (*pools)[key];
+  if (!pool) {
+    pool = std::make_unique<MemoryPool>(key.ctx, key.dev);
+  }
+  return *pool;
 }
 
 } // namespace
 
-namespace {
-
-template <ScanType ST>
-auto stream_scan(sycl::queue &q, int n, const int *d_data, int *d_out,
-                 std::span<const sycl::event> dependences = {}) -> sycl::event {
-  constexpr int BLOCK_SIZE = 1024;
-  constexpr int ELEMS = 7;
-  constexpr int BLOCK_ELEMS = BLOCK_SIZE * ELEMS;
-  constexpr int COUNTER_NUM_STARTED = 0;
-  constexpr int COUNTER_NUM_FINISHED = 1;
-
-  size_t num_groups = ceil_div(n, BLOCK_ELEMS);
-
-  int *d_atomics = sycl::malloc_device<int>(2, q);
-  int *d_per_block_exc_sums = sycl::malloc_device<int>(num_groups + 1, q);
+auto detail::allocate_workspace(sycl::queue &q, size_t bytes) -> Workspace {
+  auto block = get_pool(q).allocate(bytes);
+  return {block.first, block.second};
+}
 
-  sycl::event e = q.single_task([=] {
-    d_atomics[COUNTER_NUM_STARTED] = 0;
-    d_atomics[COUNTER_NUM_FINISHED] = 0;
-    d_per_block_exc_sums[0] = 0;
-  });
+void detail::free_workspace(sycl::queue &q, void *ptr, sycl::event release) {
+  get_pool(q).deallocate(ptr, std::move(release));
+}
 
-  e = q.submit([&](sycl::handler &cg) {
-    constexpr int SHM_ROW_ELEMS = ELEMS + (ELEMS % 2 == 0);
+auto detail::acquire_reused_workspace(sycl::queue &q, WorkspaceLayout layout,
+                                      size_t bytes, size_t tag_bytes)
+    -> ReusedWorkspace {
+  return get_pool(q).acquire_reused(q, layout, bytes, tag_bytes);
+}
 
-    sycl::local_accessor<int, 2> shm({BLOCK_SIZE, SHM_ROW_ELEMS}, cg);
-    sycl::local_accessor<int> scan_shm(BLOCK_SIZE, cg);
+void detail::release_reused_workspace(sycl::queue &q, void *ptr,
+                                      sycl::event release) {
+  get_pool(q).release_reused(ptr, std::move(release));
+}
 
-    constexpr int SHM_SIZE = BLOCK_SIZE * SHM_ROW_ELEMS + BLOCK_SIZE;
+namespace {
 
-    cg.depends_on(e);
-    depends_on(cg, dependences);
+struct PendingKernel {
+  detail::KernelLaunch launch;
+  sycl::event e;
+};
 
-    sycl::nd_range<1> range = {num_groups * BLOCK_SIZE, BLOCK_SIZE};
-    cg.parallel_for(range, [=](sycl::nd_item<1> id) {
-      auto g = id.get_group();
-      auto sg = id.get_sub_group();
-      int lid = id.get_local_id();
-      int sg_lid = sg.get_local_id();
+// Kernels launched on profiling queues and not yet taken.
+struct PendingKernels {
+  std::mutex mutex;
+  std::unordered_map<sycl::queue, std::vector<PendingKernel>> by_queue;
+};
 
-      if (lid == 0) {
-        sycl::atomic_ref<int, sycl::memory_order_relaxed,
-                         sycl::memory_scope::device,
-                         sycl::access::address_space::global_space>
-            num_started_ref(d_atomics[COUNTER_NUM_STARTED]);
-        int bid = num_started_ref.fetch_add(1);
+auto get_pending_kernels() -> PendingKernels & {
+  // Never destroyed, like the pools: the events belong to the SYCL runtime.
+  static auto *pending = new PendingKernels();
+  return *pending;
+}
 
-        scan_shm[BLOCK_SIZE - 1] = bid;
-      }
-      sycl::group_barrier(g);
+} // namespace
 
-      int bid;
-      if (sg_lid == 0) {
-        bid = scan_shm[BLOCK_SIZE - 1];
-      }
-      sycl::group_barrier(sg);
-      bid = sycl::group_broadcast(sg, bid, 0);
-
-      int r = 0;
-      for (int i = 0; i < ELEMS; ++i) {
-        int gidx = bid * BLOCK_ELEMS + lid * ELEMS + i;
-        int v;
-        if constexpr (ST == ScanType::Exclusive) {
-          v = gidx > 0 && gidx < n ? d_data[gidx - 1] : 0;
-        } else if constexpr (ST == ScanType::Inclusive) {
-          v = gidx < n ? d_data[gidx] : 0;
-        }
-        r += v;
-        shm[lid][i] = v;
-      }
-      scan_shm[lid] = r;
-      sycl::group_barrier(g);
+void detail::record_kernel(sycl::queue &q, const KernelLaunch &launch,
+                           sycl::event e) {
+  PendingKernels &pending = get_pending_kernels();
+  std::lock_guard lock(pending.mutex);
+  pending.by_queue[q].push_back({launch, std::move(e)});
+}
 
-      group_inclusive_scan<BLOCK_SIZE, 1>(g, scan_shm);
+auto take_kernel_records(sycl::queue &q) -> std::vector<KernelRecord> {
+  std::vector<PendingKernel> pending;
+  {
+    PendingKernels &pending_kernels = get_pending_kernels();
+    std::lock_guard lock(pending_kernels.mutex);
+    auto node = pending_kernels.by_queue.extract(q);
+    if (node.empty()) {
+      return {};
+    }
+    pending = std::move(node.mapped());
+  }
 
-      if (lid == 0) {
-        sycl::atomic_ref<int, sycl::memory_order_relaxed,
-                         sycl::memory_scope::device,
-                         sycl::access::address_space::global_space>
-            num_finished_ref(d_atomics[COUNTER_NUM_FINISHED]);
+  std::vector<KernelRecord> records;
+  records.reserve(pending.size());
+  for (auto &[launch, e] : pending) {
+    e.wait();
+    using namespace sycl::info::event_profiling;
+    records.push_back({launch.kernel, launch.level, launch.n, launch.bytes,
+                       e.get_profiling_info<command_submit>(),
+                       e.get_profiling_info<command_start>(),
+                       e.get_profiling_info<command_end>()});
+  }
+  return records;
+}
 
-        while (num_finished_ref.load(sycl::memory_order_acquire) != bid) {
-        }
-        int per_block_exc_sum = d_per_block_exc_sums[bid];
+void write_chrome_trace(std::ostream &os,
+                        std::span<const KernelRecord> records) {
+  // Trace times are microseconds, here from the first submission.
+  uint64_t origin = std::numeric_limits<uint64_t>::max();
+  for (const KernelRecord &r : records) {
+    origin = std::min(origin, r.submit_ns);
+  }
+  auto us = [&](uint64_t ns) {
+    return double(ns - std::min(ns, origin)) / 1e3;
+  };
 
-        int block_sum = scan_shm[BLOCK_SIZE - 1];
-        d_per_block_exc_sums[bid + 1] = per_block_exc_sum + block_sum;
-        num_finished_ref.store(bid + 1, sycl::memory_order_release);
+  std::ios::fmtflags flags = os.flags();
+  std::streamsize precision = os.precision();
+  os << std::fixed << std::setprecision(3);
+
+  os << R"({"traceEvents":[)" << "\n";
+  os << R"({"name":"thread_name","ph":"M","pid":1,"tid":1,)"
+     << R"("args":{"name":"kernels"}},)" << "\n";
+  os << R"({"name":"thread_name","ph":"M","pid":1,"tid":2,)"
+     << R"("args":{"name":"queued"}})";
+  for (const KernelRecord &r : records) {
+    uint64_t start_ns = std::max(r.start_ns, r.submit_ns);
+    uint64_t end_ns = std::max(r.end_ns, start_ns);
+    os << ",\n"
+       << R"({"name":")" << r.kernel << R"(","ph":"X","pid":1,"tid":1,"ts":)"
+       << us(start_ns) << R"(,"dur":)" << us(end_ns) - us(start_ns)
+       << R"(,"args":{"level":)" << r.level << R"(,"n":)" << r.n
+       << R"(,"bytes":)" << r.bytes << R"(,"GB/s":)" << r.gb_per_s() << "}}";
+    os << ",\n"
+       << R"({"name":")" << r.kernel << R"(","ph":"X","pid":1,"tid":2,"ts":)"
+       << us(r.submit_ns) << R"(,"dur":)" << us(start_ns) - us(r.submit_ns)
+       << "}";
+  }
+  os << "\n]}\n";
 
-        scan_shm[BLOCK_SIZE - 1] = per_block_exc_sum;
-      }
-      sycl::group_barrier(g);
+  os.flags(flags);
+  os.precision(precision);
+}
 
-      int per_block_exc_sum;
-      if (sg_lid == 0) {
-        per_block_exc_sum = scan_shm[BLOCK_SIZE - 1];
-      }
-      sycl::group_barrier(sg);
-      per_block_exc_sum = sycl::group_broadcast(sg, per_block_exc_sum, 0);
+#ifdef SYCLALGO_LOOK_BACK_STATS
+auto detail::look_back_stats_buffer(sycl::queue &q) -> uint64_t * {
+  constexpr size_t NUM_COUNTERS = NUM_LOOK_BACK_STATS * LOOK_BACK_BUCKETS;
 
-      int s = per_block_exc_sum + (lid > 0 ? scan_shm[lid - 1] : 0);
-      for (int i = 0; i < ELEMS; ++i) {
-        s += shm[lid][i];
+  static std::mutex mutex;
+  static auto *buffers = new std::unordered_map<sycl::queue, uint64_t *>();
 
-        int gidx = bid * BLOCK_ELEMS + lid * ELEMS + i;
-        if (gidx < n) {
-          d_out[gidx] = s;
-        }
-      }
-    });
-  });
+  std::lock_guard lock(mutex);
+  uint64_t *&d_histograms = (*buffers)[q];
+  if (!d_histograms) {
+    d_histograms = sycl::malloc_shared<uint64_t>(NUM_COUNTERS, q);
+    std::fill_n(d_histograms, NUM_COUNTERS, 0);
+  }
+  return d_histograms;
+}
 
-  std::thread([q, e, d_atomics, d_per_block_exc_sums]() mutable {
-    e.wait();
-    sycl::free(d_atomics, q);
-    sycl::free(d_per_block_exc_sums, q);
-  }).detach();
+auto take_look_back_stats(sycl::queue &q) -> LookBackStats {
+  uint64_t *d_histograms = detail::look_back_stats_buffer(q);
+  q.wait();
 
-  return e;
+  LookBackStats stats;
+  for (LookBackHistogram *histogram :
+       {&stats.stream_spins, &stats.look_back_spins, &stats.look_back_depth}) {
+    for (size_t &bucket : histogram->buckets) {
+      bucket = *d_histograms;
+      *d_histograms++ = 0;
+    }
+  }
+  return stats;
 }
-
-} // namespace
+#endif
 
 namespace {
 
-template <ScanType ST>
-auto spwdlb_scan(sycl::queue &q, int n, const int *d_data, int *d_out,
-                 std::span<const sycl::event> dependences = {}) -> sycl::event {
-  constexpr int BLOCK_SIZE = 256;
-  constexpr int ELEMS = 7;
-  constexpr int BLOCK_ELEMS = BLOCK_SIZE * ELEMS;
+constexpr std::pair<detail::ScanAlgorithm, std::string_view>
+    SCAN_ALGORITHM_NAMES[] = {
+        {detail::ScanAlgorithm::Recursive, "recursive"},
+        {detail::ScanAlgorithm::Stream, "stream"},
+        {detail::ScanAlgorithm::LookBack, "look-back"},
+        {detail::ScanAlgorithm::ReduceThenScan, "reduce-then-scan"},
+        {detail::ScanAlgorithm::SingleGroup, "single-group"},
+};
 
-  size_t num_groups = ceil_div(n, BLOCK_ELEMS);
+constexpr std::pair<detail::GroupScanAlgorithm, std::string_view>
+    GROUP_SCAN_ALGORITHM_NAMES[] = {
+        {detail::GroupScanAlgorithm::SubGroup, "sub-group"},
+        {detail::GroupScanAlgorithm::BrentKung, "brent-kung"},
+};
 
-  enum PartitionStatus : int {
-    Invalid = 0,
-    AggregateAvailable,
-    PrefixAvailable,
-  };
+template <typename Enum, size_t N>
+auto parse_name(const std::pair<Enum, std::string_view> (&names)[N],
+                std::string_view name) -> std::optional<Enum> {
+  for (auto [value, value_name] : names) {
+    if (value_name == name) {
+      return value;
+    }
+  }
+  return std::nullopt;
+}
 
-  struct PartitionDescriptor {
-    union {
-      struct {
-        union {
-          int32_t aggregate;
-          int32_t inclusive_prefix;
-        };
-        int32_t status;
-      };
-      int64_t value;
-    };
-  };
+template <typename Enum, size_t N>
+auto to_name(const std::pair<Enum, std::string_view> (&names)[N], Enum value)
+    -> std::string_view {
+  for (auto [v, name] : names) {
+    if (v == value) {
+      return name;
+    }
+  }
+  return {};
+}
 
-  int *d_bid = sycl::malloc_device<int>(1, q);
-  auto *d_descriptors =
-      sycl::malloc_device<PartitionDescriptor>(num_groups + 1, q) + 1;
-
-  sycl::event e =
-      q.parallel_for(sycl::range(num_groups), [=](sycl::item<1> id) {
-        if (id == 0) {
-          *d_bid = 0;
-          d_descriptors[-1] = {
-              .inclusive_prefix = 0,
-              .status = PrefixAvailable,
-          };
-        }
-        d_descriptors[id].status = Invalid;
-      });
+// Tunings are only used for the instantiated tile shapes of algorithms that
+// are safe on the device.
+auto is_usable(const detail::DeviceInfo &info,
+               const detail::ScanChoice &choice) -> bool {
+  auto configs = detail::scan_configs(choice.algorithm);
+  return detail::scan_allowed(info, choice.algorithm) &&
+         std::find(configs.begin(), configs.end(), choice.config) !=
+             configs.end();
+}
 
-  e = q.submit([&](sycl::handler &cg) {
-    constexpr int SHM_ROW_ELEMS = ELEMS + (ELEMS % 2 == 0);
+} // namespace
 
-    sycl::local_accessor<int, 2> shm({BLOCK_SIZE, SHM_ROW_ELEMS}, cg);
-    sycl::local_accessor<int> scan_shm(BLOCK_SIZE, cg);
+auto detail::scan_algorithm_name(ScanAlgorithm algorithm) -> std::string_view {
+  return to_name(SCAN_ALGORITHM_NAMES, algorithm);
+}
 
-    constexpr int SHM_SIZE = BLOCK_SIZE * SHM_ROW_ELEMS + BLOCK_SIZE;
+auto detail::group_scan_algorithm_name(GroupScanAlgorithm algorithm)
+    -> std::string_view {
+  return to_name(GROUP_SCAN_ALGORITHM_NAMES, algorithm);
+}
 
-    cg.depends_on(e);
-    depends_on(cg, dependences);
+auto detail::scan_tuning_path() -> std::filesystem::path {
+  if (const char *path = std::getenv("SYCLALGO_TUNING_FILE")) {
+    return path;
+  }
+  if (const char *home = std::getenv("HOME")) {
+    return std::filesystem::path(home) / ".cache/syclalgo/scan-tuning.tsv";
+  }
+  return {};
+}
 
-    sycl::nd_range<1> range = {num_groups * BLOCK_SIZE, BLOCK_SIZE};
-    cg.parallel_for(range, [=](sycl::nd_item<1> id) {
-      auto g = id.get_group();
-      auto sg = id.get_sub_group();
-      int lid = id.get_local_id();
-      int sg_lid = sg.get_local_id();
+auto detail::read_scan_tuning(const std::filesystem::path &path)
+    -> std::vector<ScanTuning> {
+  std::vector<ScanTuning> tunings;
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream fields(line);
+    ScanTuning tuning;
+    std::string max_n;
+    std::string algorithm;
+    std::string block_size;
+    std::string elems;
+    std::string group_scan = "sub-group";
+    if (!std::getline(fields, tuning.device_name, '\t') ||
+        !std::getline(fields, tuning.driver_version, '\t') ||
+        !std::getline(fields, max_n, '\t') ||
+        !std::getline(fields, algorithm, '\t') ||
+        !std::getline(fields, block_size, '\t') ||
+        !std::getline(fields, elems, '\t')) {
+      continue;
+    }
+    // Files written before the group scan column use the sub-group scan.
+    std::getline(fields, group_scan, '\t');
+    auto parsed_algorithm = parse_name(SCAN_ALGORITHM_NAMES, algorithm);
+    auto parsed_group_scan = parse_name(GROUP_SCAN_ALGORITHM_NAMES, group_scan);
+    if (!parsed_algorithm || !parsed_group_scan) {
+      continue;
+    }
+    tuning.choice.algorithm = *parsed_algorithm;
+    try {
+      tuning.max_n = max_n == "max" ? SIZE_MAX : std::stoull(max_n);
+      tuning.choice.config = {std::stoi(block_size), std::stoi(elems),
+                              *parsed_group_scan};
+    } catch (const std::logic_error &) {
+      continue;
+    }
+    tunings.push_back(std::move(tuning));
+  }
+  return tunings;
+}
 
-      if (lid == 0) {
-        sycl::atomic_ref<int, sycl::memory_order_relaxed,
-                         sycl::memory_scope::device,
-                         sycl::access::address_space::global_space>
-            bid_ref(*d_bid);
-        int bid = bid_ref.fetch_add(1);
-        scan_shm[BLOCK_SIZE - 1] = bid;
-      }
-      sycl::group_barrier(g);
+void detail::write_scan_tuning(const std::filesystem::path &path,
+                               std::span<const ScanTuning> tunings) {
+  if (path.has_parent_path()) {
+    std::filesystem::create_directories(path.parent_path());
+  }
+  std::ofstream file(path);
+  file << "# device\tdriver\tmax_n\talgorithm\tblock_size\telems\t"
+          "group_scan\n";
+  for (const ScanTuning &tuning : tunings) {
+    file << tuning.device_name << '\t' << tuning.driver_version << '\t';
+    if (tuning.max_n == SIZE_MAX) {
+      file << "max";
+    } else {
+      file << tuning.max_n;
+    }
+    file << '\t' << scan_algorithm_name(tuning.choice.algorithm) << '\t'
+         << tuning.choice.config.block_size << '\t'
+         << tuning.choice.config.elems << '\t'
+         << group_scan_algorithm_name(tuning.choice.config.group_scan) << '\n';
+  }
+  if (!file) {
+    throw std::runtime_error("cannot write " + path.string());
+  }
+}
 
-      int bid;
-      if (sg_lid == 0) {
-        bid = scan_shm[BLOCK_SIZE - 1];
-      }
-      sycl::group_barrier(sg);
-      bid = sycl::group_broadcast(sg, bid, 0);
-
-      int r = 0;
-      for (int i = 0; i < ELEMS; ++i) {
-        int gidx = bid * BLOCK_ELEMS + lid * ELEMS + i;
-        int v;
-        if constexpr (ST == ScanType::Exclusive) {
-          v = gidx > 0 && gidx < n ? d_data[gidx - 1] : 0;
-        } else if constexpr (ST == ScanType::Inclusive) {
-          v = gidx < n ? d_data[gidx] : 0;
-        }
-        r += v;
-        shm[lid][i] = v;
+auto detail::get_device_info(const sycl::device &dev) -> const DeviceInfo & {
+  static std::mutex mutex;
+  static auto *infos = new std::unordered_map<sycl::device, DeviceInfo>();
+  static auto *tunings = new std::vector<ScanTuning>();
+  static bool tunings_read = false;
+
+  std::lock_guard lock(mutex);
+  auto [it, inserted] = infos->try_emplace(dev);
+  if (inserted) {
+    using namespace sycl::info::device;
+    it->second = {dev.get_info<device_type>(),
+                  dev.get_info<max_work_group_size>(),
+                  dev.get_info<local_mem_size>(),
+                  dev.get_info<global_mem_cache_size>(),
+                  dev.get_info<max_compute_units>(),
+                  {}};
+
+    if (!tunings_read) {
+      *tunings = read_scan_tuning(scan_tuning_path());
+      tunings_read = true;
+    }
+    std::string device_name = dev.get_info<name>();
+    std::string device_driver = dev.get_info<driver_version>();
+    for (const ScanTuning &tuning : *tunings) {
+      if (tuning.device_name == device_name &&
+          tuning.driver_version == device_driver &&
+          is_usable(it->second, tuning.choice)) {
+        it->second.scan_tunings.push_back(tuning);
       }
-      scan_shm[lid] = r;
-      sycl::group_barrier(g);
-
-      group_inclusive_scan<BLOCK_SIZE, 1>(g, scan_shm);
-
-      if (lid == 0) {
-        sycl::atomic_ref<int64_t, sycl::memory_order_relaxed,
-                         sycl::memory_scope::device,
-                         sycl::access::address_space::global_space>
-            desc_ref(d_descriptors[bid].value);
-        {
-          int block_sum = scan_shm[BLOCK_SIZE - 1];
-          PartitionDescriptor desc = {
-              .aggregate = block_sum,
-              .status = AggregateAvailable,
-          };
-          desc_ref.store(desc.value);
-        }
-
-        int exclusive_prefix = 0;
-        for (int pid = bid - 1;; --pid) {
-          PartitionDescriptor desc;
-          do {
-            sycl::atomic_ref<int64_t, sycl::memory_order_relaxed,
-                             sycl::memory_scope::device,
-                             sycl::access::address_space::global_space>
-                desc_ref(d_descriptors[pid].value);
-            desc.value = desc_ref.load();
-          } while (desc.status == Invalid);
-          if (desc.status == AggregateAvailable) {
-            exclusive_prefix += desc.aggregate;
-          } else {
-            exclusive_prefix += desc.inclusive_prefix;
-            break;
-          }
-        }
-
-        {
-          int block_sum = scan_shm[BLOCK_SIZE - 1];
-          PartitionDescriptor desc = {
-              .inclusive_prefix = exclusive_prefix + block_sum,
-              .status = PrefixAvailable,
-          };
-          desc_ref.store(desc.value);
-        }
+    }
+    std::sort(it->second.scan_tunings.begin(), it->second.scan_tunings.end(),
+              [](const ScanTuning &a, const ScanTuning &b) {
+                return a.max_n < b.max_n;
+              });
+  }
+  return it->second;
+}
 
-        scan_shm[BLOCK_SIZE - 1] = exclusive_prefix;
-      }
+auto get_pool_stats(sycl::queue &q) -> PoolStats {
+  return get_pool(q).get_stats();
+}
 
-      sycl::group_barrier(g);
+void trim_pool(sycl::queue &q) { get_pool(q).trim(); }
 
-      int exclusive_prefix;
-      if (sg_lid == 0) {
-        exclusive_prefix = scan_shm[BLOCK_SIZE - 1];
-      }
-      sycl::group_barrier(sg);
-      exclusive_prefix = sycl::group_broadcast(sg, exclusive_prefix, 0);
+namespace {
 
-      int s = exclusive_prefix + (lid > 0 ? scan_shm[lid - 1] : 0);
-      for (int i = 0; i < ELEMS; ++i) {
-        s += shm[lid][i];
+template <typename T>
+auto axpy(sycl::queue &q, size_t n, T alpha, const T *d_x, T *d_y,
+          std::span<const sycl::event> dependences = {}) -> sycl::event {
+  if (n == 0) {
+    return {};
+  }
 
-        int gidx = bid * BLOCK_ELEMS + lid * ELEMS + i;
-        if (gidx < n) {
-          d_out[gidx] = s;
-        }
+  // Each work-item updates one whole vector, then one element of the tail.
+  constexpr int W = detail::VEC_WIDTH<T>;
+  size_t num_vecs = n / W;
+
+  detail::KernelLaunch launch = {"axpy", n, 3 * sizeof(T) * n};
+  return detail::submit_kernel(q, launch, [&](sycl::handler &cg) {
+    detail::depends_on(cg, dependences);
+    cg.parallel_for(num_vecs + n % W, [=](sycl::id<1> idx) {
+      size_t i = idx;
+      if (i < num_vecs) {
+        auto x_ptr = sycl::address_space_cast<
+            sycl::access::address_space::global_space,
+            sycl::access::decorated::no>(d_x);
+        auto y_ptr = sycl::address_space_cast<
+            sycl::access::address_space::global_space,
+            sycl::access::decorated::no>(d_y);
+        sycl::vec<T, W> x, y;
+        x.load(i, x_ptr);
+        y.load(i, y_ptr);
+        y = alpha * x + y;
+        y.store(i, y_ptr);
+      } else {
+        i = num_vecs * W + (i - num_vecs);
+        d_y[i] = alpha * d_x[i] + d_y[i];
       }
     });
   });
+}
 
-  std::thread([q, e, d_bid, d_descriptors]() mutable {
-    e.wait();
-    sycl::free(d_bid, q);
-    sycl::free(d_descriptors - 1, q);
-  }).detach();
+} // namespace
+
+auto saxpy(sycl::queue &q, size_t n, float alpha, const float *d_x, float *d_y,
+           std::span<const sycl::event> dependences) -> sycl::event {
+  return axpy(q, n, alpha, d_x, d_y, dependences);
+}
 
-  return e;
+auto scan_workspace_size(sycl::queue &q, size_t n) -> size_t {
+  return scan_workspace_size<int>(q, n);
 }
 
-} // namespace
+auto exclusive_scan(sycl::queue &q, size_t n, const int *d_data, int *d_out,
+                    std::span<const sycl::event> dependences) -> sycl::event {
+  return exclusive_scan(q, n, d_data, d_out, sycl::plus<int>(), 0, dependences);
+}
 
 auto exclusive_scan(sycl::queue &q, size_t n, const int *d_data, int *d_out,
+                    void *d_workspace, std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return exclusive_scan(q, n, d_data, d_out, sycl::plus<int>(), 0, d_workspace,
+                        dependences);
+}
+
+auto inclusive_scan(sycl::queue &q, size_t n, const int *d_data, int *d_out,
                     std::span<const sycl::event> dependences) -> sycl::event {
-  return exclusive_spwdlb_scan(q, n, d_data, d_out, dependences);
+  return inclusive_scan(q, n, d_data, d_out, sycl::plus<int>(), 0, dependences);
 }
 
 auto inclusive_scan(sycl::queue &q, size_t n, const int *d_data, int *d_out,
+                    void *d_workspace, std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return inclusive_scan(q, n, d_data, d_out, sycl::plus<int>(), 0, d_workspace,
+                        dependences);
+}
+
+auto exclusive_scan(sycl::queue &q, size_t n, const int *d_data,
+                    int64_t *d_out, std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return exclusive_scan(q, n, d_data, d_out, sycl::plus<int64_t>(), 0,
+                        dependences);
+}
+
+auto exclusive_scan(sycl::queue &q, size_t n, const int *d_data,
+                    int64_t *d_out, void *d_workspace,
+                    std::span<const sycl::event> dependences) -> sycl::event {
+  return exclusive_scan(q, n, d_data, d_out, sycl::plus<int64_t>(), 0,
+                        d_workspace, dependences);
+}
+
+auto inclusive_scan(sycl::queue &q, size_t n, const int *d_data,
+                    int64_t *d_out, std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return inclusive_scan(q, n, d_data, d_out, sycl::plus<int64_t>(), 0,
+                        dependences);
+}
+
+auto inclusive_scan(sycl::queue &q, size_t n, const int *d_data,
+                    int64_t *d_out, void *d_workspace,
                     std::span<const sycl::event> dependences) -> sycl::event {
-  return inclusive_spwdlb_scan(q, n, d_data, d_out, dependences);
+  return inclusive_scan(q, n, d_data, d_out, sycl::plus<int64_t>(), 0,
+                        d_workspace, dependences);
+}
+
+void exclusive_host_scan(sycl::queue &q, size_t n, const int *data, int *out,
+                         size_t chunk_elems) {
+  exclusive_host_scan(q, n, data, out, sycl::plus<int>(), 0, chunk_elems);
+}
+
+void inclusive_host_scan(sycl::queue &q, size_t n, const int *data, int *out,
+                         size_t chunk_elems) {
+  inclusive_host_scan(q, n, data, out, sycl::plus<int>(), 0, chunk_elems);
+}
+
+auto recursive_scan_workspace_size(sycl::queue &q, size_t n) -> size_t {
+  return recursive_scan_workspace_size<int>(q, n);
 }
 
 auto exclusive_recursive_scan(sycl::queue &q, size_t n, const int *d_data,
                               int *d_out,
                               std::span<const sycl::event> dependences)
     -> sycl::event {
-  return recursive_scan<ScanType::Exclusive>(q, n, d_data, d_out, dependences);
+  return exclusive_recursive_scan(q, n, d_data, d_out, sycl::plus<int>(), 0,
+                                  dependences);
+}
+
+auto exclusive_recursive_scan(sycl::queue &q, size_t n, const int *d_data,
+                              int *d_out, void *d_workspace,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return exclusive_recursive_scan(q, n, d_data, d_out, sycl::plus<int>(), 0,
+                                  d_workspace, dependences);
 }
 
 auto inclusive_recursive_scan(sycl::queue &q, size_t n, const int *d_data,
                               int *d_out,
                               std::span<const sycl::event> dependences)
     -> sycl::event {
-  return recursive_scan<ScanType::Inclusive>(q, n, d_data, d_out, dependences);
+  return inclusive_recursive_scan(q, n, d_data, d_out, sycl::plus<int>(), 0,
+                                  dependences);
+}
+
+auto inclusive_recursive_scan(sycl::queue &q, size_t n, const int *d_data,
+                              int *d_out, void *d_workspace,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return inclusive_recursive_scan(q, n, d_data, d_out, sycl::plus<int>(), 0,
+                                  d_workspace, dependences);
+}
+
+auto stream_scan_workspace_size(sycl::queue &q, size_t n) -> size_t {
+  return stream_scan_workspace_size<int>(q, n);
 }
 
 auto exclusive_stream_scan(sycl::queue &q, size_t n, const int *d_data,
                            int *d_out, std::span<const sycl::event> dependences)
     -> sycl::event {
-  return stream_scan<ScanType::Exclusive>(q, n, d_data, d_out, dependences);
+  return exclusive_stream_scan(q, n, d_data, d_out, sycl::plus<int>(), 0,
+                               dependences);
+}
+
+auto exclusive_stream_scan(sycl::queue &q, size_t n, const int *d_data,
+                           int *d_out, void *d_workspace,
+                           std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return exclusive_stream_scan(q, n, d_data, d_out, sycl::plus<int>(), 0,
+                               d_workspace, dependences);
 }
 
 auto inclusive_stream_scan(sycl::queue &q, size_t n, const int *d_data,
                            int *d_out, std::span<const sycl::event> dependences)
     -> sycl::event {
-  return stream_scan<ScanType::Inclusive>(q, n, d_data, d_out, dependences);
+  return inclusive_stream_scan(q, n, d_data, d_out, sycl::plus<int>(), 0,
+                               dependences);
+}
+
+auto inclusive_stream_scan(sycl::queue &q, size_t n, const int *d_data,
+                           int *d_out, void *d_workspace,
+                           std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return inclusive_stream_scan(q, n, d_data, d_out, sycl::plus<int>(), 0,
+                               d_workspace, dependences);
+}
+
+auto spwdlb_scan_workspace_size(sycl::queue &q, size_t n) -> size_t {
+  return spwdlb_scan_workspace_size<int>(q, n);
 }
 
 auto exclusive_spwdlb_scan(sycl::queue &q, size_t n, const int *d_data,
                            int *d_out, std::span<const sycl::event> dependences)
     -> sycl::event {
-  return spwdlb_scan<ScanType::Exclusive>(q, n, d_data, d_out, dependences);
+  return exclusive_spwdlb_scan(q, n, d_data, d_out, sycl::plus<int>(), 0,
+                               dependences);
+}
+
+auto exclusive_spwdlb_scan(sycl::queue &q, size_t n, const int *d_data,
+                           int *d_out, void *d_workspace,
+                           std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return exclusive_spwdlb_scan(q, n, d_data, d_out, sycl::plus<int>(), 0,
+                               d_workspace, dependences);
 }
 
 auto inclusive_spwdlb_scan(sycl::queue &q, size_t n, const int *d_data,
                            int *d_out, std::span<const sycl::event> dependences)
     -> sycl::event {
-  return spwdlb_scan<ScanType::Inclusive>(q, n, d_data, d_out, dependences);
+  return inclusive_spwdlb_scan(q, n, d_data, d_out, sycl::plus<int>(), 0,
+                               dependences);
+}
+
+auto inclusive_spwdlb_scan(sycl::queue &q, size_t n, const int *d_data,
+                           int *d_out, void *d_workspace,
+                           std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return inclusive_spwdlb_scan(q, n, d_data, d_out, sycl::plus<int>(), 0,
+                               d_workspace, dependences);
+}
+
+auto reduce_then_scan_workspace_size(sycl::queue &q, size_t n) -> size_t {
+  return reduce_then_scan_workspace_size<int>(q, n);
+}
+
+auto exclusive_reduce_then_scan(sycl::queue &q, size_t n, const int *d_data,
+                                int *d_out,
+                                std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return exclusive_reduce_then_scan(q, n, d_data, d_out, sycl::plus<int>(), 0,
+                                    dependences);
+}
+
+auto exclusive_reduce_then_scan(sycl::queue &q, size_t n, const int *d_data,
+                                int *d_out, void *d_workspace,
+                                std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return exclusive_reduce_then_scan(q, n, d_data, d_out, sycl::plus<int>(), 0,
+                                    d_workspace, dependences);
+}
+
+auto inclusive_reduce_then_scan(sycl::queue &q, size_t n, const int *d_data,
+                                int *d_out,
+                                std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return inclusive_reduce_then_scan(q, n, d_data, d_out, sycl::plus<int>(), 0,
+                                    dependences);
+}
+
+auto inclusive_reduce_then_scan(sycl::queue &q, size_t n, const int *d_data,
+                                int *d_out, void *d_workspace,
+                                std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return inclusive_reduce_then_scan(q, n, d_data, d_out, sycl::plus<int>(), 0,
+                                    d_workspace, dependences);
+}
+
+auto segmented_scan_workspace_size(sycl::queue &q, size_t n) -> size_t {
+  return segmented_scan_workspace_size<int>(q, n);
+}
+
+auto exclusive_segmented_scan(sycl::queue &q, size_t n, const int *d_data,
+                              const uint8_t *d_head_flags, int *d_out,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return exclusive_segmented_scan(q, n, d_data, d_head_flags, d_out,
+                                  sycl::plus<int>(), 0, dependences);
+}
+
+auto exclusive_segmented_scan(sycl::queue &q, size_t n, const int *d_data,
+                              const uint8_t *d_head_flags, int *d_out,
+                              void *d_workspace,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return exclusive_segmented_scan(q, n, d_data, d_head_flags, d_out,
+                                  sycl::plus<int>(), 0, d_workspace,
+                                  dependences);
+}
+
+auto exclusive_segmented_scan(sycl::queue &q, size_t n, const int *d_data,
+                              size_t num_segments, const int *d_offsets,
+                              int *d_out,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return exclusive_segmented_scan(q, n, d_data, num_segments, d_offsets, d_out,
+                                  sycl::plus<int>(), 0, dependences);
+}
+
+auto exclusive_segmented_scan(sycl::queue &q, size_t n, const int *d_data,
+                              size_t num_segments, const int *d_offsets,
+                              int *d_out, void *d_workspace,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return exclusive_segmented_scan(q, n, d_data, num_segments, d_offsets, d_out,
+                                  sycl::plus<int>(), 0, d_workspace,
+                                  dependences);
+}
+
+auto inclusive_segmented_scan(sycl::queue &q, size_t n, const int *d_data,
+                              const uint8_t *d_head_flags, int *d_out,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return inclusive_segmented_scan(q, n, d_data, d_head_flags, d_out,
+                                  sycl::plus<int>(), 0, dependences);
+}
+
+auto inclusive_segmented_scan(sycl::queue &q, size_t n, const int *d_data,
+                              const uint8_t *d_head_flags, int *d_out,
+                              void *d_workspace,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return inclusive_segmented_scan(q, n, d_data, d_head_flags, d_out,
+                                  sycl::plus<int>(), 0, d_workspace,
+                                  dependences);
+}
+
+auto inclusive_segmented_scan(sycl::queue &q, size_t n, const int *d_data,
+                              size_t num_segments, const int *d_offsets,
+                              int *d_out,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return inclusive_segmented_scan(q, n, d_data, num_segments, d_offsets, d_out,
+                                  sycl::plus<int>(), 0, dependences);
+}
+
+auto inclusive_segmented_scan(sycl::queue &q, size_t n, const int *d_data,
+                              size_t num_segments, const int *d_offsets,
+                              int *d_out, void *d_workspace,
+                              std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return inclusive_segmented_scan(q, n, d_data, num_segments, d_offsets, d_out,
+                                  sycl::plus<int>(), 0, d_workspace,
+                                  dependences);
+}
+
+auto batched_scan_workspace_size(sycl::queue &q, size_t batch, size_t n)
+    -> size_t {
+  return batched_scan_workspace_size<int>(q, batch, n);
+}
+
+auto batched_exclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            size_t stride, const int *d_data, int *d_out,
+                            std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return batched_exclusive_scan(q, batch, n, stride, d_data, d_out,
+                                sycl::plus<int>(), 0, dependences);
+}
+
+auto batched_exclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            size_t stride, const int *d_data, int *d_out,
+                            void *d_workspace,
+                            std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return batched_exclusive_scan(q, batch, n, stride, d_data, d_out,
+                                sycl::plus<int>(), 0, d_workspace, dependences);
+}
+
+auto batched_exclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            const int *const *d_data, int *const *d_out,
+                            std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return batched_exclusive_scan(q, batch, n, d_data, d_out, sycl::plus<int>(),
+                                0, dependences);
+}
+
+auto batched_exclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            const int *const *d_data, int *const *d_out,
+                            void *d_workspace,
+                            std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return batched_exclusive_scan(q, batch, n, d_data, d_out, sycl::plus<int>(),
+                                0, d_workspace, dependences);
+}
+
+auto batched_inclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            size_t stride, const int *d_data, int *d_out,
+                            std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return batched_inclusive_scan(q, batch, n, stride, d_data, d_out,
+                                sycl::plus<int>(), 0, dependences);
+}
+
+auto batched_inclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            size_t stride, const int *d_data, int *d_out,
+                            void *d_workspace,
+                            std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return batched_inclusive_scan(q, batch, n, stride, d_data, d_out,
+                                sycl::plus<int>(), 0, d_workspace, dependences);
+}
+
+auto batched_inclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            const int *const *d_data, int *const *d_out,
+                            std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return batched_inclusive_scan(q, batch, n, d_data, d_out, sycl::plus<int>(),
+                                0, dependences);
+}
+
+auto batched_inclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            const int *const *d_data, int *const *d_out,
+                            void *d_workspace,
+                            std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return batched_inclusive_scan(q, batch, n, d_data, d_out, sycl::plus<int>(),
+                                0, d_workspace, dependences);
+}
+
+auto reduce_workspace_size(sycl::queue &q, size_t n) -> size_t {
+  return reduce_workspace_size<int>(q, n);
+}
+
+auto reduce(sycl::queue &q, size_t n, const int *d_data, int *d_result,
+            std::span<const sycl::event> dependences) -> sycl::event {
+  return reduce(q, n, d_data, d_result, sycl::plus<int>(), 0, dependences);
+}
+
+auto reduce(sycl::queue &q, size_t n, const int *d_data, int *d_result,
+            void *d_workspace, std::span<const sycl::event> dependences)
+    -> sycl::event {
+  return reduce(q, n, d_data, d_result, sycl::plus<int>(), 0, d_workspace,
+                dependences);
+}
+
+auto select_workspace_size(sycl::queue &, size_t n) -> size_t {
+  return detail::select_scratch_size(n);
 }
 
 } // namespace syclalgo
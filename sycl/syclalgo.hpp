@@ -1,14 +1,136 @@
 #pragma once
+#include <array>
 #include <cstddef>
+#include <cstdint>
+#include <iosfwd>
 #include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 #include <sycl/sycl.hpp>
 
 namespace syclalgo {
 
+struct PoolStats {
+  // Bytes held by blocks that are currently handed out to algorithms.
+  size_t bytes_in_use = 0;
+  // Bytes held by free blocks waiting to be reused.
+  size_t bytes_cached = 0;
+  // Maximum of bytes_in_use + bytes_cached seen so far.
+  size_t bytes_high_water = 0;
+  size_t num_device_allocations = 0;
+  size_t num_cache_hits = 0;
+};
+
+// Temporary device memory used by the algorithms is drawn from a caching pool
+// that all queues on the same device and context share. A block is returned to
+// the pool as soon as the work using it is submitted and is handed out again to
+// work that depends on its release.
+// The stream and look-back scans keep their block with the pool between calls
+// and pick it up as the previous call left it, so that they need no launch to
+// clear it.
+auto get_pool_stats(sycl::queue &q) -> PoolStats;
+
+// Wait for pending releases and free all cached blocks of the queue's pool.
+void trim_pool(sycl::queue &q);
+
+// Timings of one kernel that an algorithm launched on a queue constructed with
+// sycl::property::queue::enable_profiling. Times are nanoseconds of the
+// device's profiling clock. Queues without the property record nothing.
+struct KernelRecord {
+  // Name of the kernel within its algorithm, e.g. "look-back init".
+  std::string_view kernel;
+  // Recursion depth of the recursive scan kernels and number of the radix sort
+  // passes, 0 for all other kernels.
+  int level = 0;
+  // Elements of the call that launched the kernel, or of the block sums that a
+  // deeper level of the recursive scan scans.
+  size_t n = 0;
+  // Bytes of global memory that the kernel reads and writes, counted from its
+  // inputs and outputs and ignoring caches.
+  size_t bytes = 0;
+  uint64_t submit_ns = 0;
+  uint64_t start_ns = 0;
+  uint64_t end_ns = 0;
+
+  auto gb_per_s() const -> double {
+    return end_ns > start_ns ? double(bytes) / double(end_ns - start_ns) : 0.0;
+  }
+};
+
+// Wait for the kernels recorded on the queue since the last call and return
+// them in submission order.
+auto take_kernel_records(sycl::queue &q) -> std::vector<KernelRecord>;
+
+// Write records in the Chrome trace event format, as read by chrome://tracing
+// and Perfetto. Each kernel shows on one track from start to end and on
+// another from submission to start, the time it waited in the queue.
+void write_chrome_trace(std::ostream &os,
+                        std::span<const KernelRecord> records);
+
+#ifdef SYCLALGO_LOOK_BACK_STATS
+// Numbers of work-groups by a count of theirs: bucket 0 holds the work-groups
+// that counted 0, bucket i > 0 those that counted [2^(i-1), 2^i), the last
+// bucket also all larger counts.
+struct LookBackHistogram {
+  std::array<size_t, 33> buckets = {};
+};
+
+struct LookBackStats {
+  // Polls of the stream scan for the running sum of the previous work-group.
+  LookBackHistogram stream_spins;
+  // Polls of the look-back scans that found a predecessor unpublished.
+  LookBackHistogram look_back_spins;
+  // Predecessors that the look-back scans combined.
+  LookBackHistogram look_back_depth;
+};
+
+// Built with SYCLALGO_LOOK_BACK_STATS, the stream and look-back scans count
+// per work-group how long they waited on their predecessors. Wait for the
+// queue and return the histograms of the counts since the last call. Without
+// the macro the counting is compiled out.
+auto take_look_back_stats(sycl::queue &q) -> LookBackStats;
+#endif
+
+// The d_ pointers that the algorithms take may point to any memory that
+// kernels on the queue's device can access: sycl::malloc_device,
+// sycl::malloc_host and sycl::malloc_shared allocations, and on devices with
+// sycl::aspect::usm_system_allocations also plain host memory, such as
+// memory-mapped files. On a CPU device, passing host-resident data directly
+// saves the copies to and from a device allocation and the memory they take.
+// Caller workspaces come from sycl::malloc_device in any case.
+
 auto saxpy(sycl::queue &q, size_t n, float a, const float *d_x, float *d_y,
            std::span<const sycl::event> dependences = {}) -> sycl::event;
 
+// Every scan comes in two forms: one that draws its temporaries from the
+// queue's pool and one that uses a caller-owned device workspace of at least
+// *_scan_workspace_size(q, n) bytes, allocated with sycl::malloc_device. The
+// workspace form never allocates; the workspace must not be reused until the
+// returned event completes.
+//
+// The int overloads compute prefix sums. The templated overloads scan any
+// trivially copyable T with an associative `op`, which need not be
+// commutative; `identity` must satisfy op(identity, x) == op(x, identity) == x.
+// Input elements are converted from InT to T before they are combined, so
+// narrow data can be accumulated in a wider type. Their workspace size depends
+// on T and is queried with the matching *_scan_workspace_size<T>.
+//
+// exclusive_scan and inclusive_scan pick one of the scans below by the device
+// type, its work-group and local memory limits, and n, unless syclalgo-tune
+// has recorded a faster scan and tile shape for the device. The workspace size
+// of the pick is given by scan_workspace_size for the same queue and n. Small
+// inputs are scanned by a single work-group in one launch and need no
+// workspace.
+
+auto scan_workspace_size(sycl::queue &q, size_t n) -> size_t;
+
+auto exclusive_scan(sycl::queue &q, size_t n, const int *d_data, int *d_out,
+                    std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
 auto exclusive_scan(sycl::queue &q, size_t n, const int *d_data, int *d_out,
+                    void *d_workspace,
                     std::span<const sycl::event> dependences = {})
     -> sycl::event;
 
@@ -16,34 +138,828 @@ auto inclusive_scan(sycl::queue &q, size_t n, const int *d_data, int *d_out,
                     std::span<const sycl::event> dependences = {})
     -> sycl::event;
 
+auto inclusive_scan(sycl::queue &q, size_t n, const int *d_data, int *d_out,
+                    void *d_workspace,
+                    std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+// Prefix sums of int data accumulated in 64 bits, for sums that overflow int.
+// The workspace form takes scan_workspace_size<int64_t>(q, n) bytes.
+auto exclusive_scan(sycl::queue &q, size_t n, const int *d_data,
+                    int64_t *d_out,
+                    std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto exclusive_scan(sycl::queue &q, size_t n, const int *d_data,
+                    int64_t *d_out, void *d_workspace,
+                    std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto inclusive_scan(sycl::queue &q, size_t n, const int *d_data,
+                    int64_t *d_out,
+                    std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto inclusive_scan(sycl::queue &q, size_t n, const int *d_data,
+                    int64_t *d_out, void *d_workspace,
+                    std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename T>
+auto scan_workspace_size(sycl::queue &q, size_t n) -> size_t;
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                    BinaryOp op, std::type_identity_t<T> identity,
+                    std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                    BinaryOp op, std::type_identity_t<T> identity,
+                    void *d_workspace,
+                    std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                    BinaryOp op, std::type_identity_t<T> identity,
+                    std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                    BinaryOp op, std::type_identity_t<T> identity,
+                    void *d_workspace,
+                    std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+// Chains a scan onto the scan of the preceding chunk of a longer input. The
+// scan starts from *d_init, or from init if d_init is null, where it would
+// start from the identity, and writes its total, the start combined with all
+// n elements, to *d_total if that is set. Passing the d_total of one chunk as
+// the d_init of the next carries the running total in device memory, without
+// a fix-up pass over the chunk. No extra kernel is launched unless n is zero.
+template <typename T> struct ScanCarry {
+  T init;
+  const T *d_init = nullptr;
+  T *d_total = nullptr;
+};
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                    BinaryOp op, std::type_identity_t<T> identity,
+                    ScanCarry<std::type_identity_t<T>> carry,
+                    std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                    BinaryOp op, std::type_identity_t<T> identity,
+                    ScanCarry<std::type_identity_t<T>> carry,
+                    void *d_workspace,
+                    std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                    BinaryOp op, std::type_identity_t<T> identity,
+                    ScanCarry<std::type_identity_t<T>> carry,
+                    std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_scan(sycl::queue &q, size_t n, const InT *d_data, T *d_out,
+                    BinaryOp op, std::type_identity_t<T> identity,
+                    ScanCarry<std::type_identity_t<T>> carry,
+                    void *d_workspace,
+                    std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+// Scans n elements of host memory into host memory, through device memory
+// that need not hold them all. The input is streamed in chunks of chunk_elems
+// elements, or about 64 MB if that is zero, on several in-order queues, so
+// that copying a chunk in, scanning the one before and copying the one before
+// that back overlap. The copies only overlap each other if the host memory is
+// pinned, e.g. allocated with sycl::malloc_host. Returns when out is written.
+// Host memory that a CPU device can access is better scanned in place by
+// exclusive_scan and inclusive_scan.
+void exclusive_host_scan(sycl::queue &q, size_t n, const int *data, int *out,
+                         size_t chunk_elems = 0);
+
+void inclusive_host_scan(sycl::queue &q, size_t n, const int *data, int *out,
+                         size_t chunk_elems = 0);
+
+template <typename InT, typename T, typename BinaryOp>
+void exclusive_host_scan(sycl::queue &q, size_t n, const InT *data, T *out,
+                         BinaryOp op, std::type_identity_t<T> identity,
+                         size_t chunk_elems = 0);
+
+template <typename InT, typename T, typename BinaryOp>
+void inclusive_host_scan(sycl::queue &q, size_t n, const InT *data, T *out,
+                         BinaryOp op, std::type_identity_t<T> identity,
+                         size_t chunk_elems = 0);
+
+// Host scans chained like exclusive_scan and inclusive_scan with a carry,
+// with d_init and d_total in device memory.
+template <typename InT, typename T, typename BinaryOp>
+void exclusive_host_scan(sycl::queue &q, size_t n, const InT *data, T *out,
+                         BinaryOp op, std::type_identity_t<T> identity,
+                         ScanCarry<std::type_identity_t<T>> carry,
+                         size_t chunk_elems = 0);
+
+template <typename InT, typename T, typename BinaryOp>
+void inclusive_host_scan(sycl::queue &q, size_t n, const InT *data, T *out,
+                         BinaryOp op, std::type_identity_t<T> identity,
+                         ScanCarry<std::type_identity_t<T>> carry,
+                         size_t chunk_elems = 0);
+
+auto recursive_scan_workspace_size(sycl::queue &q, size_t n) -> size_t;
+
 auto exclusive_recursive_scan(sycl::queue &q, size_t n, const int *d_data,
                               int *d_out,
                               std::span<const sycl::event> dependences = {})
     -> sycl::event;
 
+auto exclusive_recursive_scan(sycl::queue &q, size_t n, const int *d_data,
+                              int *d_out, void *d_workspace,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
 auto inclusive_recursive_scan(sycl::queue &q, size_t n, const int *d_data,
                               int *d_out,
                               std::span<const sycl::event> dependences = {})
     -> sycl::event;
 
+auto inclusive_recursive_scan(sycl::queue &q, size_t n, const int *d_data,
+                              int *d_out, void *d_workspace,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename T>
+auto recursive_scan_workspace_size(sycl::queue &q, size_t n) -> size_t;
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_recursive_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_recursive_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              void *d_workspace,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_recursive_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_recursive_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              void *d_workspace,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto stream_scan_workspace_size(sycl::queue &q, size_t n) -> size_t;
+
 auto exclusive_stream_scan(sycl::queue &q, size_t n, const int *d_data,
                            int *d_out,
                            std::span<const sycl::event> dependences = {})
     -> sycl::event;
 
+auto exclusive_stream_scan(sycl::queue &q, size_t n, const int *d_data,
+                           int *d_out, void *d_workspace,
+                           std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
 auto inclusive_stream_scan(sycl::queue &q, size_t n, const int *d_data,
                            int *d_out,
                            std::span<const sycl::event> dependences = {})
     -> sycl::event;
 
+auto inclusive_stream_scan(sycl::queue &q, size_t n, const int *d_data,
+                           int *d_out, void *d_workspace,
+                           std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename T>
+auto stream_scan_workspace_size(sycl::queue &q, size_t n) -> size_t;
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_stream_scan(sycl::queue &q, size_t n, const InT *d_data,
+                           T *d_out, BinaryOp op,
+                           std::type_identity_t<T> identity,
+                           std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_stream_scan(sycl::queue &q, size_t n, const InT *d_data,
+                           T *d_out, BinaryOp op,
+                           std::type_identity_t<T> identity, void *d_workspace,
+                           std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_stream_scan(sycl::queue &q, size_t n, const InT *d_data,
+                           T *d_out, BinaryOp op,
+                           std::type_identity_t<T> identity,
+                           std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_stream_scan(sycl::queue &q, size_t n, const InT *d_data,
+                           T *d_out, BinaryOp op,
+                           std::type_identity_t<T> identity, void *d_workspace,
+                           std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto spwdlb_scan_workspace_size(sycl::queue &q, size_t n) -> size_t;
+
 auto exclusive_spwdlb_scan(sycl::queue &q, size_t n, const int *d_data,
                            int *d_out,
                            std::span<const sycl::event> dependences = {})
     -> sycl::event;
 
+auto exclusive_spwdlb_scan(sycl::queue &q, size_t n, const int *d_data,
+                           int *d_out, void *d_workspace,
+                           std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
 auto inclusive_spwdlb_scan(sycl::queue &q, size_t n, const int *d_data,
                            int *d_out,
                            std::span<const sycl::event> dependences = {})
     -> sycl::event;
 
+auto inclusive_spwdlb_scan(sycl::queue &q, size_t n, const int *d_data,
+                           int *d_out, void *d_workspace,
+                           std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename T>
+auto spwdlb_scan_workspace_size(sycl::queue &q, size_t n) -> size_t;
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_spwdlb_scan(sycl::queue &q, size_t n, const InT *d_data,
+                           T *d_out, BinaryOp op,
+                           std::type_identity_t<T> identity,
+                           std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_spwdlb_scan(sycl::queue &q, size_t n, const InT *d_data,
+                           T *d_out, BinaryOp op,
+                           std::type_identity_t<T> identity, void *d_workspace,
+                           std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_spwdlb_scan(sycl::queue &q, size_t n, const InT *d_data,
+                           T *d_out, BinaryOp op,
+                           std::type_identity_t<T> identity,
+                           std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_spwdlb_scan(sycl::queue &q, size_t n, const InT *d_data,
+                           T *d_out, BinaryOp op,
+                           std::type_identity_t<T> identity, void *d_workspace,
+                           std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+// Reduce-then-scan never waits on other work-groups, so it is safe on devices
+// without forward progress guarantees between work-groups, such as CPU
+// backends. exclusive_scan and inclusive_scan use it on such devices, as do
+// the segmented, batched and transform scans, the selection algorithms and
+// radix_sort. The stream and look-back scans always wait on their
+// predecessors and need a device that guarantees forward progress.
+
+auto reduce_then_scan_workspace_size(sycl::queue &q, size_t n) -> size_t;
+
+auto exclusive_reduce_then_scan(sycl::queue &q, size_t n, const int *d_data,
+                                int *d_out,
+                                std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto exclusive_reduce_then_scan(sycl::queue &q, size_t n, const int *d_data,
+                                int *d_out, void *d_workspace,
+                                std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto inclusive_reduce_then_scan(sycl::queue &q, size_t n, const int *d_data,
+                                int *d_out,
+                                std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto inclusive_reduce_then_scan(sycl::queue &q, size_t n, const int *d_data,
+                                int *d_out, void *d_workspace,
+                                std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename T>
+auto reduce_then_scan_workspace_size(sycl::queue &q, size_t n) -> size_t;
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_reduce_then_scan(sycl::queue &q, size_t n, const InT *d_data,
+                                T *d_out, BinaryOp op,
+                                std::type_identity_t<T> identity,
+                                std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_reduce_then_scan(sycl::queue &q, size_t n, const InT *d_data,
+                                T *d_out, BinaryOp op,
+                                std::type_identity_t<T> identity,
+                                void *d_workspace,
+                                std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_reduce_then_scan(sycl::queue &q, size_t n, const InT *d_data,
+                                T *d_out, BinaryOp op,
+                                std::type_identity_t<T> identity,
+                                std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_reduce_then_scan(sycl::queue &q, size_t n, const InT *d_data,
+                                T *d_out, BinaryOp op,
+                                std::type_identity_t<T> identity,
+                                void *d_workspace,
+                                std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+// Segmented scans restart at the start of every segment. Segments are given
+// either by head flags, where a nonzero d_head_flags[i] starts a segment at
+// element i, or by the CSR-style offsets of num_segments segments, where
+// segment s starts at element d_offsets[s]. Elements before the first start
+// form a segment of their own. Either form runs as a single pass.
+
+auto segmented_scan_workspace_size(sycl::queue &q, size_t n) -> size_t;
+
+auto exclusive_segmented_scan(sycl::queue &q, size_t n, const int *d_data,
+                              const uint8_t *d_head_flags, int *d_out,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto exclusive_segmented_scan(sycl::queue &q, size_t n, const int *d_data,
+                              const uint8_t *d_head_flags, int *d_out,
+                              void *d_workspace,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto exclusive_segmented_scan(sycl::queue &q, size_t n, const int *d_data,
+                              size_t num_segments, const int *d_offsets,
+                              int *d_out,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto exclusive_segmented_scan(sycl::queue &q, size_t n, const int *d_data,
+                              size_t num_segments, const int *d_offsets,
+                              int *d_out, void *d_workspace,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto inclusive_segmented_scan(sycl::queue &q, size_t n, const int *d_data,
+                              const uint8_t *d_head_flags, int *d_out,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto inclusive_segmented_scan(sycl::queue &q, size_t n, const int *d_data,
+                              const uint8_t *d_head_flags, int *d_out,
+                              void *d_workspace,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto inclusive_segmented_scan(sycl::queue &q, size_t n, const int *d_data,
+                              size_t num_segments, const int *d_offsets,
+                              int *d_out,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto inclusive_segmented_scan(sycl::queue &q, size_t n, const int *d_data,
+                              size_t num_segments, const int *d_offsets,
+                              int *d_out, void *d_workspace,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename T>
+auto segmented_scan_workspace_size(sycl::queue &q, size_t n) -> size_t;
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_segmented_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              const uint8_t *d_head_flags, T *d_out,
+                              BinaryOp op, std::type_identity_t<T> identity,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto exclusive_segmented_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              const uint8_t *d_head_flags, T *d_out,
+                              BinaryOp op, std::type_identity_t<T> identity,
+                              void *d_workspace,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename OffsetT, typename T, typename BinaryOp>
+auto exclusive_segmented_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              size_t num_segments, const OffsetT *d_offsets,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename OffsetT, typename T, typename BinaryOp>
+auto exclusive_segmented_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              size_t num_segments, const OffsetT *d_offsets,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              void *d_workspace,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_segmented_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              const uint8_t *d_head_flags, T *d_out,
+                              BinaryOp op, std::type_identity_t<T> identity,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto inclusive_segmented_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              const uint8_t *d_head_flags, T *d_out,
+                              BinaryOp op, std::type_identity_t<T> identity,
+                              void *d_workspace,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename OffsetT, typename T, typename BinaryOp>
+auto inclusive_segmented_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              size_t num_segments, const OffsetT *d_offsets,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename OffsetT, typename T, typename BinaryOp>
+auto inclusive_segmented_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              size_t num_segments, const OffsetT *d_offsets,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              void *d_workspace,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+// Batched scans scan `batch` independent rows of n elements in one pass. Rows
+// are either strided, with row r at d_data + r * stride and d_out + r * stride,
+// or given by device-accessible arrays of row pointers.
+
+auto batched_scan_workspace_size(sycl::queue &q, size_t batch, size_t n)
+    -> size_t;
+
+auto batched_exclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            size_t stride, const int *d_data, int *d_out,
+                            std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto batched_exclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            size_t stride, const int *d_data, int *d_out,
+                            void *d_workspace,
+                            std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto batched_exclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            const int *const *d_data, int *const *d_out,
+                            std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto batched_exclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            const int *const *d_data, int *const *d_out,
+                            void *d_workspace,
+                            std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto batched_inclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            size_t stride, const int *d_data, int *d_out,
+                            std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto batched_inclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            size_t stride, const int *d_data, int *d_out,
+                            void *d_workspace,
+                            std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto batched_inclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            const int *const *d_data, int *const *d_out,
+                            std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+auto batched_inclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            const int *const *d_data, int *const *d_out,
+                            void *d_workspace,
+                            std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename T>
+auto batched_scan_workspace_size(sycl::queue &q, size_t batch, size_t n)
+    -> size_t;
+
+template <typename InT, typename T, typename BinaryOp>
+auto batched_exclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            size_t stride, const InT *d_data, T *d_out,
+                            BinaryOp op, std::type_identity_t<T> identity,
+                            std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto batched_exclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            size_t stride, const InT *d_data, T *d_out,
+                            BinaryOp op, std::type_identity_t<T> identity,
+                            void *d_workspace,
+                            std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto batched_exclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            const InT *const *d_data, T *const *d_out,
+                            BinaryOp op, std::type_identity_t<T> identity,
+                            std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto batched_exclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            const InT *const *d_data, T *const *d_out,
+                            BinaryOp op, std::type_identity_t<T> identity,
+                            void *d_workspace,
+                            std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto batched_inclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            size_t stride, const InT *d_data, T *d_out,
+                            BinaryOp op, std::type_identity_t<T> identity,
+                            std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto batched_inclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            size_t stride, const InT *d_data, T *d_out,
+                            BinaryOp op, std::type_identity_t<T> identity,
+                            void *d_workspace,
+                            std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto batched_inclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            const InT *const *d_data, T *const *d_out,
+                            BinaryOp op, std::type_identity_t<T> identity,
+                            std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto batched_inclusive_scan(sycl::queue &q, size_t batch, size_t n,
+                            const InT *const *d_data, T *const *d_out,
+                            BinaryOp op, std::type_identity_t<T> identity,
+                            void *d_workspace,
+                            std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+// Transform scans fuse elementwise maps into the single pass of a scan.
+// transform_*_scan(q, n, d_data, d_out, op, identity, transform) scans
+// transform(d_data[i]) like std::transform_*_scan. The functor form instead
+// reads element i as input(i) and passes result i to output(i, value), which
+// may read several arrays, transform or scatter. Both are device-callable.
+
+template <typename T>
+auto transform_scan_workspace_size(sycl::queue &q, size_t n) -> size_t;
+
+template <typename InT, typename T, typename BinaryOp, typename UnaryOp>
+auto transform_exclusive_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              UnaryOp transform,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp, typename UnaryOp>
+auto transform_exclusive_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              UnaryOp transform, void *d_workspace,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename Input, typename Output, typename T, typename BinaryOp>
+auto transform_exclusive_scan(sycl::queue &q, size_t n, Input input,
+                              Output output, BinaryOp op, T identity,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename Input, typename Output, typename T, typename BinaryOp>
+auto transform_exclusive_scan(sycl::queue &q, size_t n, Input input,
+                              Output output, BinaryOp op, T identity,
+                              void *d_workspace,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp, typename UnaryOp>
+auto transform_inclusive_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              UnaryOp transform,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp, typename UnaryOp>
+auto transform_inclusive_scan(sycl::queue &q, size_t n, const InT *d_data,
+                              T *d_out, BinaryOp op,
+                              std::type_identity_t<T> identity,
+                              UnaryOp transform, void *d_workspace,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename Input, typename Output, typename T, typename BinaryOp>
+auto transform_inclusive_scan(sycl::queue &q, size_t n, Input input,
+                              Output output, BinaryOp op, T identity,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename Input, typename Output, typename T, typename BinaryOp>
+auto transform_inclusive_scan(sycl::queue &q, size_t n, Input input,
+                              Output output, BinaryOp op, T identity,
+                              void *d_workspace,
+                              std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+// Reductions combine the elements in an unspecified order, like std::reduce, so
+// `op` must be associative and commutative. They run as a single launch and
+// write the result to the device-accessible *d_result, which is `identity` for
+// n == 0. The int overloads compute sums.
+
+auto reduce_workspace_size(sycl::queue &q, size_t n) -> size_t;
+
+auto reduce(sycl::queue &q, size_t n, const int *d_data, int *d_result,
+            std::span<const sycl::event> dependences = {}) -> sycl::event;
+
+auto reduce(sycl::queue &q, size_t n, const int *d_data, int *d_result,
+            void *d_workspace, std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename T>
+auto reduce_workspace_size(sycl::queue &q, size_t n) -> size_t;
+
+template <typename InT, typename T, typename BinaryOp>
+auto reduce(sycl::queue &q, size_t n, const InT *d_data, T *d_result,
+            BinaryOp op, std::type_identity_t<T> identity,
+            std::span<const sycl::event> dependences = {}) -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp>
+auto reduce(sycl::queue &q, size_t n, const InT *d_data, T *d_result,
+            BinaryOp op, std::type_identity_t<T> identity, void *d_workspace,
+            std::span<const sycl::event> dependences = {}) -> sycl::event;
+
+// Reduces transform(d_data[i]) like std::transform_reduce. The workspace size
+// depends on T.
+template <typename InT, typename T, typename BinaryOp, typename UnaryOp>
+auto transform_reduce(sycl::queue &q, size_t n, const InT *d_data,
+                      T *d_result, BinaryOp op,
+                      std::type_identity_t<T> identity, UnaryOp transform,
+                      std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename InT, typename T, typename BinaryOp, typename UnaryOp>
+auto transform_reduce(sycl::queue &q, size_t n, const InT *d_data,
+                      T *d_result, BinaryOp op,
+                      std::type_identity_t<T> identity, UnaryOp transform,
+                      void *d_workspace,
+                      std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+// argmin and argmax write the index of the first smallest or largest element,
+// like std::min_element and std::max_element, or n if there is none.
+
+template <typename T>
+auto arg_reduce_workspace_size(sycl::queue &q, size_t n) -> size_t;
+
+template <typename T>
+auto argmin(sycl::queue &q, size_t n, const T *d_data, size_t *d_index,
+            std::span<const sycl::event> dependences = {}) -> sycl::event;
+
+template <typename T>
+auto argmin(sycl::queue &q, size_t n, const T *d_data, size_t *d_index,
+            void *d_workspace, std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename T>
+auto argmax(sycl::queue &q, size_t n, const T *d_data, size_t *d_index,
+            std::span<const sycl::event> dependences = {}) -> sycl::event;
+
+template <typename T>
+auto argmax(sycl::queue &q, size_t n, const T *d_data, size_t *d_index,
+            void *d_workspace, std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+// The selection algorithms are stable and run as a single decoupled look-back
+// pass, or on devices without forward progress guarantees as a count pass
+// followed by a scatter pass. They write their count to the device-accessible
+// *d_num_selected, *d_num_kept or *d_count. Outputs must not overlap the
+// input.
+
+auto select_workspace_size(sycl::queue &q, size_t n) -> size_t;
+
+// Copies the elements satisfying `pred`.
+template <typename T, typename Pred>
+auto copy_if(sycl::queue &q, size_t n, const T *d_data, T *d_out, Pred pred,
+             size_t *d_num_selected,
+             std::span<const sycl::event> dependences = {}) -> sycl::event;
+
+template <typename T, typename Pred>
+auto copy_if(sycl::queue &q, size_t n, const T *d_data, T *d_out, Pred pred,
+             size_t *d_num_selected, void *d_workspace,
+             std::span<const sycl::event> dependences = {}) -> sycl::event;
+
+// Copies the elements not satisfying `pred`.
+template <typename T, typename Pred>
+auto remove_if(sycl::queue &q, size_t n, const T *d_data, T *d_out, Pred pred,
+               size_t *d_num_kept,
+               std::span<const sycl::event> dependences = {}) -> sycl::event;
+
+template <typename T, typename Pred>
+auto remove_if(sycl::queue &q, size_t n, const T *d_data, T *d_out, Pred pred,
+               size_t *d_num_kept, void *d_workspace,
+               std::span<const sycl::event> dependences = {}) -> sycl::event;
+
+// Copies the elements satisfying `pred` to d_selected and the others to
+// d_rejected.
+template <typename T, typename Pred>
+auto partition(sycl::queue &q, size_t n, const T *d_data, T *d_selected,
+               T *d_rejected, Pred pred, size_t *d_num_selected,
+               std::span<const sycl::event> dependences = {}) -> sycl::event;
+
+template <typename T, typename Pred>
+auto partition(sycl::queue &q, size_t n, const T *d_data, T *d_selected,
+               T *d_rejected, Pred pred, size_t *d_num_selected,
+               void *d_workspace,
+               std::span<const sycl::event> dependences = {}) -> sycl::event;
+
+// Counts the elements satisfying `pred` as a transform_reduce, in one launch
+// without any waiting between work-groups.
+template <typename T, typename Pred>
+auto count_if(sycl::queue &q, size_t n, const T *d_data, Pred pred,
+              size_t *d_count, std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename T, typename Pred>
+auto count_if(sycl::queue &q, size_t n, const T *d_data, Pred pred,
+              size_t *d_count, void *d_workspace,
+              std::span<const sycl::event> dependences = {}) -> sycl::event;
+
+// Radix sorts order 32- and 64-bit integer and floating-point keys, optionally
+// carrying a value per key, and are stable. Floats order -0.0 before +0.0 and
+// NaNs after the infinities of their sign. The output may alias the input.
+
+template <typename K>
+auto radix_sort_keys_workspace_size(sycl::queue &q, size_t n) -> size_t;
+
+template <typename K, typename V>
+auto radix_sort_pairs_workspace_size(sycl::queue &q, size_t n) -> size_t;
+
+template <typename K>
+auto radix_sort_keys(sycl::queue &q, size_t n, const K *d_keys, K *d_keys_out,
+                     std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename K>
+auto radix_sort_keys(sycl::queue &q, size_t n, const K *d_keys, K *d_keys_out,
+                     void *d_workspace,
+                     std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename K, typename V>
+auto radix_sort_pairs(sycl::queue &q, size_t n, const K *d_keys,
+                      K *d_keys_out, const V *d_values, V *d_values_out,
+                      std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
+template <typename K, typename V>
+auto radix_sort_pairs(sycl::queue &q, size_t n, const K *d_keys,
+                      K *d_keys_out, const V *d_values, V *d_values_out,
+                      void *d_workspace,
+                      std::span<const sycl::event> dependences = {})
+    -> sycl::event;
+
 } // namespace syclalgo
+
+#include "syclalgo-reduce.hpp"
+#include "syclalgo-scan.hpp"
+#include "syclalgo-select.hpp"
+#include "syclalgo-sort.hpp"
@@ -82,6 +82,43 @@ void saxpy(benchmark::State &state) {
   sycl::free(d_y, q);
 }
 
+// Host-resident data, either copied to device memory and back around saxpy or
+// used in place from a host allocation.
+void saxpy_host_data(benchmark::State &state) {
+  size_t n = state.range(0);
+  bool zero_copy = state.range(1);
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  float *h_x = sycl::malloc_host<float>(n, q);
+  float *h_y = sycl::malloc_host<float>(n, q);
+  std::iota(h_x, h_x + n, 1);
+  std::iota(h_y, h_y + n, 1);
+
+  float *d_x = zero_copy ? h_x : sycl::malloc_device<float>(n, q);
+  float *d_y = zero_copy ? h_y : sycl::malloc_device<float>(n, q);
+
+  for (auto _ : state) {
+    float alpha = 1.0f;
+    if (!zero_copy) {
+      q.copy(h_x, d_x, n);
+      q.copy(h_y, d_y, n);
+    }
+    syclalgo::saxpy(q, n, alpha, d_x, d_y);
+    if (!zero_copy) {
+      q.copy(d_y, h_y, n);
+    }
+    q.wait();
+  }
+
+  if (!zero_copy) {
+    sycl::free(d_x, q);
+    sycl::free(d_y, q);
+  }
+  sycl::free(h_x, q);
+  sycl::free(h_y, q);
+}
+
 constexpr size_t MB = 1024 * 1024;
 
 constexpr size_t MIN_COUNT = 1 * MB / sizeof(float);
@@ -91,5 +128,8 @@ BENCHMARK(std_memcpy)->RangeMultiplier(2)->Range(MIN_COUNT, MAX_COUNT);
 BENCHMARK(std_tranform)->RangeMultiplier(2)->Range(MIN_COUNT, MAX_COUNT);
 BENCHMARK(sycl_memcpy)->RangeMultiplier(2)->Range(MIN_COUNT, MAX_COUNT);
 BENCHMARK(saxpy)->RangeMultiplier(2)->Range(MIN_COUNT, MAX_COUNT);
+BENCHMARK(saxpy_host_data)
+    ->ArgNames({"n", "zero_copy"})
+    ->ArgsProduct({benchmark::CreateRange(MIN_COUNT, MAX_COUNT, 8), {0, 1}});
 
 } // namespace
@@ -1,5 +1,6 @@
 #include "syclalgo.hpp"
 #include <benchmark/benchmark.h>
+#include <algorithm>
 #include <cstring>
 #include <numeric>
 #if ONEDPL
@@ -39,6 +40,7 @@ void std_scan(benchmark::State &state) {
     benchmark::DoNotOptimize(out);
     benchmark::ClobberMemory();
   }
+  state.SetBytesProcessed(state.iterations() * 2 * sizeof(int) * n);
 }
 
 void sycl_memcpy(benchmark::State &state) {
@@ -157,10 +159,448 @@ void spwdlb_scan(benchmark::State &state) {
   sycl::free(d_result, q);
 }
 
+void reduce_then_scan(benchmark::State &state) {
+  size_t n = state.range(0);
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  int *d_data = sycl::malloc_device<int>(n, q);
+  {
+    std::vector<int> data(n);
+    std::iota(data.begin(), data.end(), 1);
+    q.copy(data.data(), d_data, n);
+  };
+
+  int *d_result = sycl::malloc_device<int>(n, q);
+
+  for (auto _ : state) {
+    syclalgo::exclusive_reduce_then_scan(q, n, d_data, d_result).wait();
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+}
+
+void spwdlb_scan_latency(benchmark::State &state) {
+  size_t n = state.range(0);
+  bool cached = state.range(1);
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  int *d_data = sycl::malloc_device<int>(n, q);
+  {
+    std::vector<int> data(n);
+    std::iota(data.begin(), data.end(), 1);
+    q.copy(data.data(), d_data, n);
+  };
+
+  int *d_result = sycl::malloc_device<int>(n, q);
+
+  for (auto _ : state) {
+    syclalgo::exclusive_spwdlb_scan(q, n, d_data, d_result).wait();
+    if (!cached) {
+      syclalgo::trim_pool(q);
+    }
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+}
+
+// The default scan on inputs from a few tiles up, where launches and
+// workspaces dominate.
+void scan_latency(benchmark::State &state) {
+  size_t n = state.range(0);
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  int *d_data = sycl::malloc_device<int>(n, q);
+  {
+    std::vector<int> data(n);
+    std::iota(data.begin(), data.end(), 1);
+    q.copy(data.data(), d_data, n);
+  };
+
+  int *d_result = sycl::malloc_device<int>(n, q);
+
+  for (auto _ : state) {
+    syclalgo::exclusive_scan(q, n, d_data, d_result).wait();
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+}
+
+// Host-resident data, either copied to device memory and back around the scan
+// or used in place from a host allocation.
+void scan_host_data(benchmark::State &state) {
+  size_t n = state.range(0);
+  bool zero_copy = state.range(1);
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  int *h_data = sycl::malloc_host<int>(n, q);
+  int *h_result = sycl::malloc_host<int>(n, q);
+  std::iota(h_data, h_data + n, 1);
+
+  int *d_data = zero_copy ? h_data : sycl::malloc_device<int>(n, q);
+  int *d_result = zero_copy ? h_result : sycl::malloc_device<int>(n, q);
+
+  for (auto _ : state) {
+    if (!zero_copy) {
+      q.copy(h_data, d_data, n);
+    }
+    syclalgo::exclusive_scan(q, n, d_data, d_result);
+    if (!zero_copy) {
+      q.copy(d_result, h_result, n);
+    }
+    q.wait();
+  }
+  state.SetBytesProcessed(state.iterations() * 2 * sizeof(int) * n);
+
+  if (!zero_copy) {
+    sycl::free(d_data, q);
+    sycl::free(d_result, q);
+  }
+  sycl::free(h_data, q);
+  sycl::free(h_result, q);
+}
+
+// Host to host through the device, for comparison with std_scan. Copies only
+// overlap for pinned host memory.
+void host_scan(benchmark::State &state) {
+  size_t n = state.range(0);
+  bool pinned = state.range(1);
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::vector<int> pageable_data;
+  std::vector<int> pageable_result;
+  int *data;
+  int *result;
+  if (pinned) {
+    data = sycl::malloc_host<int>(n, q);
+    result = sycl::malloc_host<int>(n, q);
+  } else {
+    pageable_data.resize(n);
+    pageable_result.resize(n);
+    data = pageable_data.data();
+    result = pageable_result.data();
+  }
+  std::iota(data, data + n, 1);
+
+  for (auto _ : state) {
+    syclalgo::exclusive_host_scan(q, n, data, result);
+  }
+  state.SetBytesProcessed(state.iterations() * 2 * sizeof(int) * n);
+
+  if (pinned) {
+    sycl::free(data, q);
+    sycl::free(result, q);
+  }
+}
+
+// A caller workspace is cleared by an extra launch before every scan, the
+// queue's reused workspace is not.
+void spwdlb_scan_reused_workspace(benchmark::State &state) {
+  size_t n = state.range(0);
+  bool reused = state.range(1);
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  int *d_data = sycl::malloc_device<int>(n, q);
+  {
+    std::vector<int> data(n);
+    std::iota(data.begin(), data.end(), 1);
+    q.copy(data.data(), d_data, n);
+  };
+
+  int *d_result = sycl::malloc_device<int>(n, q);
+  void *d_workspace = sycl::malloc_device(
+      syclalgo::spwdlb_scan_workspace_size<int>(q, n), q);
+
+  for (auto _ : state) {
+    if (reused) {
+      syclalgo::exclusive_spwdlb_scan(q, n, d_data, d_result).wait();
+    } else {
+      syclalgo::exclusive_spwdlb_scan(q, n, d_data, d_result, d_workspace)
+          .wait();
+    }
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+  sycl::free(d_workspace, q);
+}
+
+void spwdlb_scan_int64(benchmark::State &state) {
+  size_t n = state.range(0);
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  int *d_data = sycl::malloc_device<int>(n, q);
+  int64_t *d_result = sycl::malloc_device<int64_t>(n, q);
+  if (!d_data || !d_result) {
+    state.SkipWithError("device allocation failed");
+    sycl::free(d_data, q);
+    sycl::free(d_result, q);
+    return;
+  }
+  q.fill(d_data, 1, n);
+
+  for (auto _ : state) {
+    syclalgo::exclusive_spwdlb_scan(q, n, d_data, d_result,
+                                    sycl::plus<int64_t>(), int64_t(0))
+        .wait();
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+}
+
+void segmented_scan(benchmark::State &state) {
+  size_t n = state.range(0);
+  size_t segment_length = state.range(1);
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  int *d_data = sycl::malloc_device<int>(n, q);
+  {
+    std::vector<int> data(n);
+    std::iota(data.begin(), data.end(), 1);
+    q.copy(data.data(), d_data, n);
+  };
+
+  size_t num_segments = (n + segment_length - 1) / segment_length;
+  int *d_offsets = sycl::malloc_device<int>(num_segments + 1, q);
+  {
+    std::vector<int> offsets(num_segments + 1);
+    for (size_t s = 0; s <= num_segments; ++s) {
+      offsets[s] = std::min(s * segment_length, n);
+    }
+    q.copy(offsets.data(), d_offsets, num_segments + 1);
+  };
+
+  int *d_result = sycl::malloc_device<int>(n, q);
+
+  for (auto _ : state) {
+    syclalgo::exclusive_segmented_scan(q, n, d_data, num_segments, d_offsets,
+                                       d_result)
+        .wait();
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_offsets, q);
+  sycl::free(d_result, q);
+}
+
+void spwdlb_scan_rows(benchmark::State &state) {
+  size_t batch = state.range(0);
+  size_t n = state.range(1);
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  int *d_data = sycl::malloc_device<int>(batch * n, q);
+  q.fill(d_data, 1, batch * n);
+
+  int *d_result = sycl::malloc_device<int>(batch * n, q);
+
+  for (auto _ : state) {
+    for (size_t row = 0; row < batch; ++row) {
+      syclalgo::exclusive_spwdlb_scan(q, n, d_data + row * n,
+                                      d_result + row * n);
+    }
+    q.wait();
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+}
+
+void batched_scan(benchmark::State &state) {
+  size_t batch = state.range(0);
+  size_t n = state.range(1);
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  int *d_data = sycl::malloc_device<int>(batch * n, q);
+  q.fill(d_data, 1, batch * n);
+
+  int *d_result = sycl::malloc_device<int>(batch * n, q);
+
+  for (auto _ : state) {
+    syclalgo::batched_exclusive_scan(q, batch, n, n, d_data, d_result).wait();
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+}
+
+void flag_then_scan(benchmark::State &state) {
+  size_t n = state.range(0);
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  int *d_data = sycl::malloc_device<int>(n, q);
+  {
+    std::vector<int> data(n);
+    std::iota(data.begin(), data.end(), 1);
+    q.copy(data.data(), d_data, n);
+  };
+
+  int *d_flags = sycl::malloc_device<int>(n, q);
+  int *d_result = sycl::malloc_device<int>(n, q);
+
+  for (auto _ : state) {
+    q.parallel_for(n, [=](sycl::id<1> i) { d_flags[i] = d_data[i] % 2 == 0; });
+    syclalgo::exclusive_scan(q, n, d_flags, d_result).wait();
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_flags, q);
+  sycl::free(d_result, q);
+}
+
+void transform_scan(benchmark::State &state) {
+  size_t n = state.range(0);
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  int *d_data = sycl::malloc_device<int>(n, q);
+  {
+    std::vector<int> data(n);
+    std::iota(data.begin(), data.end(), 1);
+    q.copy(data.data(), d_data, n);
+  };
+
+  int *d_result = sycl::malloc_device<int>(n, q);
+
+  for (auto _ : state) {
+    syclalgo::transform_exclusive_scan(q, n, d_data, d_result,
+                                       sycl::plus<int>(), 0,
+                                       [](int v) { return v % 2 == 0; })
+        .wait();
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+}
+
+void flag_scan_scatter(benchmark::State &state) {
+  size_t n = state.range(0);
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  int *d_data = sycl::malloc_device<int>(n, q);
+  {
+    std::vector<int> data(n);
+    std::iota(data.begin(), data.end(), 1);
+    q.copy(data.data(), d_data, n);
+  };
+
+  int *d_flags = sycl::malloc_device<int>(n, q);
+  int *d_offsets = sycl::malloc_device<int>(n, q);
+  int *d_result = sycl::malloc_device<int>(n, q);
+
+  for (auto _ : state) {
+    q.parallel_for(n, [=](sycl::id<1> i) { d_flags[i] = d_data[i] % 2 == 0; });
+    syclalgo::exclusive_scan(q, n, d_flags, d_offsets);
+    q.parallel_for(n, [=](sycl::id<1> i) {
+      if (d_flags[i]) {
+        d_result[d_offsets[i]] = d_data[i];
+      }
+    });
+    q.wait();
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_flags, q);
+  sycl::free(d_offsets, q);
+  sycl::free(d_result, q);
+}
+
+void copy_if(benchmark::State &state) {
+  size_t n = state.range(0);
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  int *d_data = sycl::malloc_device<int>(n, q);
+  {
+    std::vector<int> data(n);
+    std::iota(data.begin(), data.end(), 1);
+    q.copy(data.data(), d_data, n);
+  };
+
+  int *d_result = sycl::malloc_device<int>(n, q);
+  size_t *d_count = sycl::malloc_device<size_t>(1, q);
+
+  for (auto _ : state) {
+    syclalgo::copy_if(q, n, d_data, d_result,
+                      [](int v) { return v % 2 == 0; }, d_count)
+        .wait();
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+  sycl::free(d_count, q);
+}
+
+void scan_then_last(benchmark::State &state) {
+  size_t n = state.range(0);
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  int *d_data = sycl::malloc_device<int>(n, q);
+  {
+    std::vector<int> data(n);
+    std::iota(data.begin(), data.end(), 1);
+    q.copy(data.data(), d_data, n);
+  };
+
+  int *d_result = sycl::malloc_device<int>(n, q);
+
+  int sum;
+  for (auto _ : state) {
+    syclalgo::inclusive_scan(q, n, d_data, d_result);
+    q.copy(d_result + n - 1, &sum, 1).wait();
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+}
+
+void reduce(benchmark::State &state) {
+  size_t n = state.range(0);
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  int *d_data = sycl::malloc_device<int>(n, q);
+  {
+    std::vector<int> data(n);
+    std::iota(data.begin(), data.end(), 1);
+    q.copy(data.data(), d_data, n);
+  };
+
+  int *d_sum = sycl::malloc_device<int>(1, q);
+
+  int sum;
+  for (auto _ : state) {
+    syclalgo::reduce(q, n, d_data, d_sum);
+    q.copy(d_sum, &sum, 1).wait();
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_sum, q);
+}
+
+constexpr size_t KB = 1024;
 constexpr size_t MB = 1024 * 1024;
+constexpr size_t GB = 1024 * 1024 * 1024;
 
 constexpr size_t MIN_COUNT = 1 * MB / sizeof(int);
 constexpr size_t MAX_COUNT = 512 * MB / sizeof(int);
+// Past 2^31 elements, for the 64-bit indexing paths.
+constexpr size_t LARGE_MAX_COUNT = 16 * GB / sizeof(int);
 
 BENCHMARK(std_memcpy)->RangeMultiplier(2)->Range(MIN_COUNT, MAX_COUNT);
 BENCHMARK(std_scan)->RangeMultiplier(2)->Range(MIN_COUNT, MAX_COUNT);
@@ -171,5 +611,42 @@ BENCHMARK(onedpl_scan)->RangeMultiplier(2)->Range(MIN_COUNT, MAX_COUNT);
 BENCHMARK(recursive_scan)->RangeMultiplier(2)->Range(MIN_COUNT, MAX_COUNT);
 BENCHMARK(stream_scan)->RangeMultiplier(2)->Range(MIN_COUNT, MAX_COUNT);
 BENCHMARK(spwdlb_scan)->RangeMultiplier(2)->Range(MIN_COUNT, MAX_COUNT);
+BENCHMARK(reduce_then_scan)
+    ->RangeMultiplier(2)
+    ->Range(MIN_COUNT, MAX_COUNT);
+BENCHMARK(flag_then_scan)->RangeMultiplier(2)->Range(MIN_COUNT, MAX_COUNT);
+BENCHMARK(transform_scan)->RangeMultiplier(2)->Range(MIN_COUNT, MAX_COUNT);
+BENCHMARK(flag_scan_scatter)->RangeMultiplier(2)->Range(MIN_COUNT, MAX_COUNT);
+BENCHMARK(copy_if)->RangeMultiplier(2)->Range(MIN_COUNT, MAX_COUNT);
+BENCHMARK(scan_then_last)->RangeMultiplier(2)->Range(MIN_COUNT, MAX_COUNT);
+BENCHMARK(reduce)->RangeMultiplier(2)->Range(MIN_COUNT, MAX_COUNT);
+BENCHMARK(spwdlb_scan_int64)
+    ->RangeMultiplier(2)
+    ->Range(MIN_COUNT, LARGE_MAX_COUNT);
+BENCHMARK(segmented_scan)
+    ->ArgNames({"n", "segment_length"})
+    ->ArgsProduct({benchmark::CreateRange(MIN_COUNT, MAX_COUNT, 8),
+                   {64, 4096}});
+BENCHMARK(spwdlb_scan_rows)
+    ->ArgNames({"batch", "n"})
+    ->ArgsProduct({{1024, 16 * KB}, {4 * KB, 64 * KB}});
+BENCHMARK(batched_scan)
+    ->ArgNames({"batch", "n"})
+    ->ArgsProduct({{1024, 16 * KB}, {4 * KB, 64 * KB}});
+BENCHMARK(spwdlb_scan_latency)
+    ->ArgNames({"n", "cached"})
+    ->ArgsProduct({benchmark::CreateRange(4 * KB / sizeof(int), MIN_COUNT, 4),
+                   {0, 1}});
+BENCHMARK(scan_latency)->RangeMultiplier(4)->Range(1 * KB, 1 * MB);
+BENCHMARK(scan_host_data)
+    ->ArgNames({"n", "zero_copy"})
+    ->ArgsProduct({benchmark::CreateRange(MIN_COUNT, MAX_COUNT, 8), {0, 1}});
+BENCHMARK(host_scan)
+    ->ArgNames({"n", "pinned"})
+    ->ArgsProduct({benchmark::CreateRange(MIN_COUNT, MAX_COUNT, 8), {0, 1}});
+BENCHMARK(spwdlb_scan_reused_workspace)
+    ->ArgNames({"n", "reused"})
+    ->ArgsProduct({benchmark::CreateRange(4 * KB / sizeof(int), MIN_COUNT, 4),
+                   {0, 1}});
 
 } // namespace
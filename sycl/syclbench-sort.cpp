@@ -0,0 +1,121 @@
+#include "syclalgo.hpp"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <execution>
+#include <random>
+
+namespace {
+
+template <typename K> auto random_keys(size_t n) -> std::vector<K> {
+  std::mt19937_64 rng(42);
+  std::vector<K> keys(n);
+  for (K &key : keys) {
+    if constexpr (std::is_floating_point_v<K>) {
+      key = std::uniform_real_distribution<K>(-1, 1)(rng);
+    } else {
+      key = K(rng());
+    }
+  }
+  return keys;
+}
+
+template <typename K> void std_sort(benchmark::State &state) {
+  size_t n = state.range(0);
+
+  std::vector<K> keys = random_keys<K>(n);
+
+  // Sorting in place needs a fresh copy of the keys every iteration, which
+  // stands in for the separate output of the radix sorts.
+  std::vector<K> result(n);
+  for (auto _ : state) {
+    std::copy(keys.begin(), keys.end(), result.begin());
+    std::sort(std::execution::par, result.begin(), result.end());
+    auto out = result.data();
+    benchmark::DoNotOptimize(out);
+    benchmark::ClobberMemory();
+  }
+}
+
+template <typename K> void std_stable_sort(benchmark::State &state) {
+  size_t n = state.range(0);
+
+  std::vector<K> keys = random_keys<K>(n);
+
+  std::vector<K> result(n);
+  for (auto _ : state) {
+    std::copy(keys.begin(), keys.end(), result.begin());
+    std::stable_sort(std::execution::par, result.begin(), result.end());
+    auto out = result.data();
+    benchmark::DoNotOptimize(out);
+    benchmark::ClobberMemory();
+  }
+}
+
+template <typename K> void radix_sort_keys(benchmark::State &state) {
+  size_t n = state.range(0);
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  K *d_keys = sycl::malloc_device<K>(n, q);
+  q.copy(random_keys<K>(n).data(), d_keys, n).wait();
+
+  K *d_result = sycl::malloc_device<K>(n, q);
+
+  for (auto _ : state) {
+    syclalgo::radix_sort_keys(q, n, d_keys, d_result).wait();
+  }
+
+  sycl::free(d_keys, q);
+  sycl::free(d_result, q);
+}
+
+template <typename K> void radix_sort_pairs(benchmark::State &state) {
+  size_t n = state.range(0);
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  K *d_keys = sycl::malloc_device<K>(n, q);
+  q.copy(random_keys<K>(n).data(), d_keys, n).wait();
+
+  uint32_t *d_values = sycl::malloc_device<uint32_t>(n, q);
+  q.parallel_for(n, [=](sycl::id<1> i) { d_values[i] = i; });
+
+  K *d_keys_out = sycl::malloc_device<K>(n, q);
+  uint32_t *d_values_out = sycl::malloc_device<uint32_t>(n, q);
+
+  for (auto _ : state) {
+    syclalgo::radix_sort_pairs(q, n, d_keys, d_keys_out, d_values,
+                               d_values_out)
+        .wait();
+  }
+
+  sycl::free(d_keys, q);
+  sycl::free(d_values, q);
+  sycl::free(d_keys_out, q);
+  sycl::free(d_values_out, q);
+}
+
+constexpr size_t MB = 1024 * 1024;
+
+constexpr size_t MIN_COUNT = 1 * MB / sizeof(uint32_t);
+constexpr size_t MAX_COUNT = 512 * MB / sizeof(uint32_t);
+
+BENCHMARK(std_sort<uint32_t>)->RangeMultiplier(4)->Range(MIN_COUNT, MAX_COUNT);
+BENCHMARK(std_stable_sort<uint32_t>)
+    ->RangeMultiplier(4)
+    ->Range(MIN_COUNT, MAX_COUNT);
+BENCHMARK(radix_sort_keys<uint32_t>)
+    ->RangeMultiplier(2)
+    ->Range(MIN_COUNT, MAX_COUNT);
+BENCHMARK(radix_sort_keys<float>)
+    ->RangeMultiplier(2)
+    ->Range(MIN_COUNT, MAX_COUNT);
+BENCHMARK(radix_sort_keys<uint64_t>)
+    ->RangeMultiplier(2)
+    ->Range(MIN_COUNT, MAX_COUNT / 2);
+BENCHMARK(radix_sort_pairs<uint32_t>)
+    ->RangeMultiplier(2)
+    ->Range(MIN_COUNT, MAX_COUNT);
+
+} // namespace
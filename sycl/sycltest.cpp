@@ -1,7 +1,16 @@
 #include "syclalgo.hpp"
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <fcntl.h>
+#include <fstream>
 #include <gtest/gtest.h>
+#include <iterator>
+#include <limits>
 #include <numeric>
+#include <sstream>
+#include <sys/mman.h>
+#include <unistd.h>
 
 namespace {
 
@@ -37,6 +46,41 @@ TEST(Axpy, Saxpy) {
   EXPECT_EQ(y, result);
 }
 
+TEST(Axpy, RaggedSaxpy) {
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  float alpha = 2.0f;
+
+  for (size_t n : {1, 7, 1'003}) {
+    SCOPED_TRACE(testing::Message() << "n = " << n);
+
+    std::vector<float> x(n);
+    std::iota(x.begin(), x.end(), 1);
+
+    std::vector<float> y(n, 3.0f);
+
+    // One element in, so that the vectors start off their natural alignment.
+    float *d_x = sycl::malloc_device<float>(n + 1, q);
+    q.copy(x.data(), d_x + 1, n);
+
+    float *d_y = sycl::malloc_device<float>(n + 1, q);
+    q.copy(y.data(), d_y + 1, n);
+
+    syclalgo::saxpy(q, n, alpha, d_x + 1, d_y + 1);
+
+    std::transform(x.begin(), x.end(), y.begin(), y.begin(),
+                   [&](float x, float y) { return alpha * x + y; });
+
+    std::vector<float> result(n);
+    q.copy(d_y + 1, result.data(), n).wait();
+
+    sycl::free(d_x, q);
+    sycl::free(d_y, q);
+
+    EXPECT_EQ(y, result);
+  }
+}
+
 void test_exclusive_recursive_scan(sycl::queue &q, size_t n) {
   std::vector<int> data(n);
   std::iota(data.begin(), data.end(), 1);
@@ -255,4 +299,1863 @@ TEST(Scan, InclusiveSPWDLBScan) {
   }
 }
 
+void test_exclusive_reduce_then_scan(sycl::queue &q, size_t n) {
+  std::vector<int> data(n);
+  std::iota(data.begin(), data.end(), 1);
+
+  std::vector<int> scan(n);
+  std::exclusive_scan(data.begin(), data.end(), scan.begin(), 0);
+
+  int *d_data = sycl::malloc_device<int>(n, q);
+  sycl::event e = q.copy(data.data(), d_data, n);
+
+  int *d_result = sycl::malloc_device<int>(n, q);
+
+  e = syclalgo::exclusive_reduce_then_scan(q, n, d_data, d_result, {&e, 1});
+
+  std::vector<int> result(n);
+  q.copy(d_result, result.data(), n, e).wait();
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+
+  EXPECT_EQ(scan, result);
+}
+
+TEST(Scan, ExclusiveReduceThenScan) {
+  sycl::queue q;
+  {
+    SCOPED_TRACE("exclusive_reduce_then_scan: single tile");
+    test_exclusive_reduce_then_scan(q, 100);
+  }
+  {
+    SCOPED_TRACE("exclusive_reduce_then_scan: multi tile");
+    test_exclusive_reduce_then_scan(q, 1'000'003);
+  }
+}
+
+void test_inclusive_reduce_then_scan(sycl::queue &q, size_t n) {
+  std::vector<int> data(n);
+  std::iota(data.begin(), data.end(), 1);
+
+  std::vector<int> scan(n);
+  std::inclusive_scan(data.begin(), data.end(), scan.begin());
+
+  int *d_data = sycl::malloc_device<int>(n, q);
+  sycl::event e = q.copy(data.data(), d_data, n);
+
+  int *d_result = sycl::malloc_device<int>(n, q);
+
+  e = syclalgo::inclusive_reduce_then_scan(q, n, d_data, d_result, {&e, 1});
+
+  std::vector<int> result(n);
+  q.copy(d_result, result.data(), n, e).wait();
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+
+  EXPECT_EQ(scan, result);
+}
+
+TEST(Scan, InclusiveReduceThenScan) {
+  sycl::queue q;
+  {
+    SCOPED_TRACE("inclusive_reduce_then_scan: single tile");
+    test_inclusive_reduce_then_scan(q, 100);
+  }
+  {
+    SCOPED_TRACE("inclusive_reduce_then_scan: multi tile");
+    test_inclusive_reduce_then_scan(q, 1'000'003);
+  }
+}
+
+struct Affine {
+  int64_t a;
+  int64_t b;
+
+  auto operator==(const Affine &) const -> bool = default;
+};
+
+// Composition x -> g(f(x)), which is associative but not commutative.
+struct AffineCompose {
+  auto operator()(const Affine &f, const Affine &g) const -> Affine {
+    return {g.a * f.a, g.a * f.b + g.b};
+  }
+};
+
+template <typename InT, typename T, typename BinaryOp>
+void test_typed_scans(const std::vector<InT> &data, BinaryOp op, T identity) {
+  size_t n = data.size();
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::vector<T> exclusive(n);
+  std::exclusive_scan(data.begin(), data.end(), exclusive.begin(), identity,
+                      op);
+
+  std::vector<T> inclusive(n);
+  std::inclusive_scan(data.begin(), data.end(), inclusive.begin(), op,
+                      identity);
+
+  InT *d_data = sycl::malloc_device<InT>(n, q);
+  q.copy(data.data(), d_data, n);
+
+  T *d_result = sycl::malloc_device<T>(n, q);
+
+  std::vector<T> result(n);
+  auto check = [&](const std::vector<T> &scan) {
+    q.copy(d_result, result.data(), n).wait();
+    EXPECT_TRUE(scan == result);
+  };
+
+  {
+    SCOPED_TRACE("exclusive_scan");
+    syclalgo::exclusive_scan(q, n, d_data, d_result, op, identity);
+    check(exclusive);
+  }
+  {
+    SCOPED_TRACE("inclusive_scan");
+    syclalgo::inclusive_scan(q, n, d_data, d_result, op, identity);
+    check(inclusive);
+  }
+  {
+    SCOPED_TRACE("exclusive_recursive_scan");
+    syclalgo::exclusive_recursive_scan(q, n, d_data, d_result, op, identity);
+    check(exclusive);
+  }
+  {
+    SCOPED_TRACE("inclusive_recursive_scan");
+    syclalgo::inclusive_recursive_scan(q, n, d_data, d_result, op, identity);
+    check(inclusive);
+  }
+  {
+    SCOPED_TRACE("exclusive_stream_scan");
+    syclalgo::exclusive_stream_scan(q, n, d_data, d_result, op, identity);
+    check(exclusive);
+  }
+  {
+    SCOPED_TRACE("inclusive_stream_scan");
+    syclalgo::inclusive_stream_scan(q, n, d_data, d_result, op, identity);
+    check(inclusive);
+  }
+  {
+    SCOPED_TRACE("exclusive_spwdlb_scan");
+    syclalgo::exclusive_spwdlb_scan(q, n, d_data, d_result, op, identity);
+    check(exclusive);
+  }
+  {
+    SCOPED_TRACE("inclusive_spwdlb_scan");
+    syclalgo::inclusive_spwdlb_scan(q, n, d_data, d_result, op, identity);
+    check(inclusive);
+  }
+  {
+    SCOPED_TRACE("exclusive_reduce_then_scan");
+    syclalgo::exclusive_reduce_then_scan(q, n, d_data, d_result, op,
+                                         identity);
+    check(exclusive);
+  }
+  {
+    SCOPED_TRACE("inclusive_reduce_then_scan");
+    syclalgo::inclusive_reduce_then_scan(q, n, d_data, d_result, op,
+                                         identity);
+    check(inclusive);
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+}
+
+TEST(Scan, UnalignedRuns) {
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  // Offsets that start the runs off vector boundaries, with ragged ends.
+  for (size_t n : {1, 13, 1'000, 100'003}) {
+    for (size_t offset : {0, 1, 3}) {
+      SCOPED_TRACE(testing::Message() << "n = " << n << ", offset = "
+                                      << offset);
+
+      std::vector<int8_t> data(n);
+      for (size_t i = 0; i < n; ++i) {
+        data[i] = int8_t(i * 7 % 23) - 11;
+      }
+
+      std::vector<int64_t> exclusive(n);
+      std::exclusive_scan(data.begin(), data.end(), exclusive.begin(),
+                          int64_t(0));
+
+      std::vector<int64_t> inclusive(n);
+      std::inclusive_scan(data.begin(), data.end(), inclusive.begin(),
+                          std::plus<int64_t>(), int64_t(0));
+
+      int8_t *d_data = sycl::malloc_device<int8_t>(n + offset, q);
+      q.copy(data.data(), d_data + offset, n);
+
+      int64_t *d_result = sycl::malloc_device<int64_t>(n + offset, q);
+
+      std::vector<int64_t> result(n);
+
+      syclalgo::exclusive_reduce_then_scan(q, n, d_data + offset,
+                                           d_result + offset,
+                                           std::plus<int64_t>(), int64_t(0));
+      q.copy(d_result + offset, result.data(), n).wait();
+      EXPECT_EQ(exclusive, result);
+
+      syclalgo::inclusive_reduce_then_scan(q, n, d_data + offset,
+                                           d_result + offset,
+                                           std::plus<int64_t>(), int64_t(0));
+      q.copy(d_result + offset, result.data(), n).wait();
+      EXPECT_EQ(inclusive, result);
+
+      sycl::free(d_data, q);
+      sycl::free(d_result, q);
+    }
+  }
+}
+
+TEST(Scan, TypedScan) {
+  size_t n = 100'000;
+  {
+    SCOPED_TRACE("int64_t plus");
+    std::vector<int64_t> data(n);
+    std::iota(data.begin(), data.end(), int64_t(1) << 32);
+    test_typed_scans(data, sycl::plus<int64_t>(), int64_t(0));
+  }
+  {
+    SCOPED_TRACE("uint32_t maximum");
+    std::vector<uint32_t> data(n);
+    for (size_t i = 0; i < n; ++i) {
+      data[i] = (i * 7919) % 100'003;
+    }
+    test_typed_scans(data, sycl::maximum<uint32_t>(), uint32_t(0));
+  }
+  {
+    SCOPED_TRACE("float plus");
+    std::vector<float> data(n);
+    for (size_t i = 0; i < n; ++i) {
+      data[i] = i % 16;
+    }
+    test_typed_scans(data, sycl::plus<float>(), 0.0f);
+  }
+  {
+    SCOPED_TRACE("double minimum");
+    std::vector<double> data(n);
+    for (size_t i = 0; i < n; ++i) {
+      data[i] = -0.5 * ((i * 7919) % 100'003);
+    }
+    test_typed_scans(data, sycl::minimum<double>(),
+                     std::numeric_limits<double>::infinity());
+  }
+  {
+    SCOPED_TRACE("affine composition");
+    std::vector<Affine> data(n);
+    for (size_t i = 0; i < n; ++i) {
+      data[i] = {i % 3 == 0 ? -1 : 1, int64_t(i % 7)};
+    }
+    test_typed_scans(data, AffineCompose(), Affine{1, 0});
+  }
+  {
+    SCOPED_TRACE("int to int64_t plus");
+    std::vector<int> data(n);
+    for (size_t i = 0; i < n; ++i) {
+      data[i] = i % 2 == 0 ? 1 << 30 : -(1 << 20);
+    }
+    test_typed_scans(data, sycl::plus<int64_t>(), int64_t(0));
+  }
+}
+
+TEST(Scan, WideAccumulator) {
+  size_t n = 100'000;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::vector<int> data(n, std::numeric_limits<int>::max());
+
+  std::vector<int64_t> exclusive(n);
+  std::exclusive_scan(data.begin(), data.end(), exclusive.begin(), int64_t(0));
+
+  std::vector<int64_t> inclusive(n);
+  std::inclusive_scan(data.begin(), data.end(), inclusive.begin(),
+                      std::plus<int64_t>(), int64_t(0));
+
+  int *d_data = sycl::malloc_device<int>(n, q);
+  q.copy(data.data(), d_data, n);
+
+  int64_t *d_result = sycl::malloc_device<int64_t>(n, q);
+
+  size_t workspace_size = syclalgo::scan_workspace_size<int64_t>(q, n);
+  void *d_workspace = sycl::malloc_device(workspace_size, q);
+
+  std::vector<int64_t> result(n);
+
+  syclalgo::exclusive_scan(q, n, d_data, d_result);
+  q.copy(d_result, result.data(), n).wait();
+  EXPECT_EQ(exclusive, result);
+
+  syclalgo::exclusive_scan(q, n, d_data, d_result, d_workspace);
+  q.copy(d_result, result.data(), n).wait();
+  EXPECT_EQ(exclusive, result);
+
+  syclalgo::inclusive_scan(q, n, d_data, d_result);
+  q.copy(d_result, result.data(), n).wait();
+  EXPECT_EQ(inclusive, result);
+
+  syclalgo::inclusive_scan(q, n, d_data, d_result, d_workspace);
+  q.copy(d_result, result.data(), n).wait();
+  EXPECT_EQ(inclusive, result);
+
+  sycl::free(d_workspace, q);
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+}
+
+TEST(Scan, SegmentedScan) {
+  size_t n = 100'000;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::vector<int> data(n);
+  std::iota(data.begin(), data.end(), 1);
+
+  // Empty segments, short ones and ones that span several partitions.
+  constexpr std::array<int, 8> LENGTHS = {0, 1, 5, 3000, 17, 0, 250, 9000};
+  std::vector<int> offsets = {0};
+  while (offsets.back() < int(n)) {
+    int length = LENGTHS[offsets.size() % LENGTHS.size()];
+    offsets.push_back(std::min(offsets.back() + length, int(n)));
+  }
+  size_t num_segments = offsets.size() - 1;
+
+  std::vector<uint8_t> head_flags(n);
+  for (size_t s = 0; s < num_segments; ++s) {
+    if (offsets[s] < int(n)) {
+      head_flags[offsets[s]] = 1;
+    }
+  }
+
+  std::vector<int> exclusive(n);
+  std::vector<int> inclusive(n);
+  int sum = 0;
+  for (size_t i = 0; i < n; ++i) {
+    sum = head_flags[i] ? 0 : sum;
+    exclusive[i] = sum;
+    sum += data[i];
+    inclusive[i] = sum;
+  }
+
+  int *d_data = sycl::malloc_device<int>(n, q);
+  q.copy(data.data(), d_data, n);
+
+  uint8_t *d_head_flags = sycl::malloc_device<uint8_t>(n, q);
+  q.copy(head_flags.data(), d_head_flags, n);
+
+  int *d_offsets = sycl::malloc_device<int>(offsets.size(), q);
+  q.copy(offsets.data(), d_offsets, offsets.size());
+
+  int *d_result = sycl::malloc_device<int>(n, q);
+
+  void *d_workspace =
+      sycl::malloc_device(syclalgo::segmented_scan_workspace_size(q, n), q);
+
+  std::vector<int> result(n);
+  auto check = [&](const std::vector<int> &scan) {
+    q.copy(d_result, result.data(), n).wait();
+    EXPECT_EQ(scan, result);
+  };
+
+  {
+    SCOPED_TRACE("exclusive head flags");
+    syclalgo::exclusive_segmented_scan(q, n, d_data, d_head_flags, d_result);
+    check(exclusive);
+  }
+  {
+    SCOPED_TRACE("inclusive head flags");
+    syclalgo::inclusive_segmented_scan(q, n, d_data, d_head_flags, d_result,
+                                       d_workspace);
+    check(inclusive);
+  }
+  {
+    SCOPED_TRACE("exclusive offsets");
+    syclalgo::exclusive_segmented_scan(q, n, d_data, num_segments, d_offsets,
+                                       d_result, d_workspace);
+    check(exclusive);
+  }
+  {
+    SCOPED_TRACE("inclusive offsets");
+    syclalgo::inclusive_segmented_scan(q, n, d_data, num_segments, d_offsets,
+                                       d_result);
+    check(inclusive);
+  }
+
+  sycl::free(d_workspace, q);
+  sycl::free(d_data, q);
+  sycl::free(d_head_flags, q);
+  sycl::free(d_offsets, q);
+  sycl::free(d_result, q);
+}
+
+TEST(Scan, TypedSegmentedScan) {
+  size_t n = 100'000;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::vector<Affine> data(n);
+  std::vector<int64_t> offsets = {0};
+  for (size_t i = 0; i < n; ++i) {
+    data[i] = {i % 3 == 0 ? -1 : 1, int64_t(i % 7)};
+    if ((i * 7919) % 1000 == 0 && i > 0) {
+      offsets.push_back(i);
+    }
+  }
+  offsets.push_back(n);
+  size_t num_segments = offsets.size() - 1;
+
+  AffineCompose op;
+  Affine identity = {1, 0};
+
+  std::vector<Affine> exclusive(n);
+  std::vector<Affine> inclusive(n);
+  Affine sum = identity;
+  for (size_t i = 0, s = 0; i < n; ++i) {
+    if (s < num_segments && offsets[s] == int64_t(i)) {
+      sum = identity;
+      ++s;
+    }
+    exclusive[i] = sum;
+    sum = op(sum, data[i]);
+    inclusive[i] = sum;
+  }
+
+  Affine *d_data = sycl::malloc_device<Affine>(n, q);
+  q.copy(data.data(), d_data, n);
+
+  int64_t *d_offsets = sycl::malloc_device<int64_t>(offsets.size(), q);
+  q.copy(offsets.data(), d_offsets, offsets.size());
+
+  Affine *d_result = sycl::malloc_device<Affine>(n, q);
+
+  std::vector<Affine> result(n);
+
+  syclalgo::exclusive_segmented_scan(q, n, d_data, num_segments, d_offsets,
+                                     d_result, op, identity);
+  q.copy(d_result, result.data(), n).wait();
+  EXPECT_TRUE(exclusive == result);
+
+  syclalgo::inclusive_segmented_scan(q, n, d_data, num_segments, d_offsets,
+                                     d_result, op, identity);
+  q.copy(d_result, result.data(), n).wait();
+  EXPECT_TRUE(inclusive == result);
+
+  sycl::free(d_data, q);
+  sycl::free(d_offsets, q);
+  sycl::free(d_result, q);
+}
+
+TEST(Scan, BatchedScan) {
+  size_t batch = 37;
+  size_t n = 5000;
+  size_t stride = n + 3;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::vector<int> data(batch * stride);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = (i * 7919) % 1000 - 500;
+  }
+
+  std::vector<int> exclusive(data.size());
+  std::vector<int> inclusive(data.size());
+  for (size_t row = 0; row < batch; ++row) {
+    auto first = data.begin() + row * stride;
+    std::exclusive_scan(first, first + n, exclusive.begin() + row * stride, 0);
+    std::inclusive_scan(first, first + n, inclusive.begin() + row * stride);
+  }
+
+  int *d_data = sycl::malloc_device<int>(data.size(), q);
+  q.copy(data.data(), d_data, data.size());
+
+  int *d_result = sycl::malloc_device<int>(data.size(), q);
+
+  // Row pointers in reverse order.
+  std::vector<const int *> data_rows(batch);
+  std::vector<int *> result_rows(batch);
+  for (size_t row = 0; row < batch; ++row) {
+    data_rows[row] = d_data + (batch - row - 1) * stride;
+    result_rows[row] = d_result + (batch - row - 1) * stride;
+  }
+  const int **d_data_rows = sycl::malloc_device<const int *>(batch, q);
+  q.copy(data_rows.data(), d_data_rows, batch);
+  int **d_result_rows = sycl::malloc_device<int *>(batch, q);
+  q.copy(result_rows.data(), d_result_rows, batch);
+
+  void *d_workspace = sycl::malloc_device(
+      syclalgo::batched_scan_workspace_size(q, batch, n), q);
+
+  std::vector<int> result(data.size());
+  auto check = [&](const std::vector<int> &scan) {
+    q.copy(d_result, result.data(), data.size()).wait();
+    for (size_t row = 0; row < batch; ++row) {
+      SCOPED_TRACE(row);
+      auto first = result.begin() + row * stride;
+      EXPECT_TRUE(std::equal(first, first + n, scan.begin() + row * stride));
+    }
+  };
+
+  {
+    SCOPED_TRACE("exclusive strided");
+    syclalgo::batched_exclusive_scan(q, batch, n, stride, d_data, d_result);
+    check(exclusive);
+  }
+  {
+    SCOPED_TRACE("inclusive strided");
+    syclalgo::batched_inclusive_scan(q, batch, n, stride, d_data, d_result,
+                                     d_workspace);
+    check(inclusive);
+  }
+  {
+    SCOPED_TRACE("exclusive row pointers");
+    syclalgo::batched_exclusive_scan(q, batch, n, d_data_rows, d_result_rows,
+                                     d_workspace);
+    check(exclusive);
+  }
+  {
+    SCOPED_TRACE("inclusive row pointers");
+    syclalgo::batched_inclusive_scan(q, batch, n, d_data_rows, d_result_rows);
+    check(inclusive);
+  }
+
+  sycl::free(d_workspace, q);
+  sycl::free(d_data_rows, q);
+  sycl::free(d_result_rows, q);
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+}
+
+// The path of the batched and segmented scans on devices without forward
+// progress, which the other tests only take on such devices.
+TEST(Scan, ReduceThenScanRows) {
+  size_t batch = 37;
+  size_t n = 5000;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::vector<int> data(batch * n);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = (i * 7919) % 1000 - 500;
+  }
+
+  std::vector<int> inclusive(data.size());
+  for (size_t row = 0; row < batch; ++row) {
+    auto first = data.begin() + row * n;
+    std::inclusive_scan(first, first + n, inclusive.begin() + row * n);
+  }
+
+  int *d_data = sycl::malloc_device<int>(data.size(), q);
+  q.copy(data.data(), d_data, data.size());
+
+  int *d_result = sycl::malloc_device<int>(data.size(), q);
+
+  void *d_workspace = sycl::malloc_device(
+      syclalgo::batched_scan_workspace_size(q, batch, n), q);
+
+  auto load = [=](size_t row, size_t gidx) { return d_data[row * n + gidx]; };
+  auto store = [=](size_t row, size_t gidx, int value) {
+    d_result[row * n + gidx] = value;
+  };
+  syclalgo::detail::reduce_then_scan_rows(q, batch, n, load, store,
+                                          sycl::plus<int>(), 0, d_workspace)
+      .wait();
+
+  std::vector<int> result(data.size());
+  q.copy(d_result, result.data(), data.size()).wait();
+  EXPECT_EQ(result, inclusive);
+
+  sycl::free(d_workspace, q);
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+}
+
+TEST(Scan, TransformScan) {
+  size_t n = 100'000;
+  int a = 3;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::vector<int> x(n);
+  std::vector<int> y(n);
+  for (size_t i = 0; i < n; ++i) {
+    x[i] = (i * 7919) % 1000;
+    y[i] = i % 17;
+  }
+
+  auto is_even = [](int v) { return v % 2 == 0 ? 1 : 0; };
+  std::vector<int> offsets(n);
+  std::transform_exclusive_scan(x.begin(), x.end(), offsets.begin(), 0,
+                                std::plus<int>(), is_even);
+
+  std::vector<int64_t> axpy_sums(n);
+  int64_t sum = 0;
+  for (size_t i = 0; i < n; ++i) {
+    sum += a * x[i] + y[i];
+    axpy_sums[i] = 2 * sum;
+  }
+
+  int *d_x = sycl::malloc_device<int>(n, q);
+  q.copy(x.data(), d_x, n);
+  int *d_y = sycl::malloc_device<int>(n, q);
+  q.copy(y.data(), d_y, n);
+
+  int *d_offsets = sycl::malloc_device<int>(n, q);
+  int64_t *d_axpy_sums = sycl::malloc_device<int64_t>(n, q);
+
+  void *d_workspace = sycl::malloc_device(
+      syclalgo::transform_scan_workspace_size<int64_t>(q, n), q);
+
+  std::vector<int> result(n);
+  syclalgo::transform_exclusive_scan(q, n, d_x, d_offsets, sycl::plus<int>(),
+                                     0, is_even);
+  q.copy(d_offsets, result.data(), n).wait();
+  EXPECT_EQ(offsets, result);
+
+  std::vector<int64_t> wide_result(n);
+  syclalgo::transform_inclusive_scan(
+      q, n, [=](size_t i) { return int64_t(a) * d_x[i] + d_y[i]; },
+      [=](size_t i, int64_t s) { d_axpy_sums[i] = 2 * s; },
+      sycl::plus<int64_t>(), int64_t(0), d_workspace);
+  q.copy(d_axpy_sums, wide_result.data(), n).wait();
+  EXPECT_EQ(axpy_sums, wide_result);
+
+  sycl::free(d_workspace, q);
+  sycl::free(d_x, q);
+  sycl::free(d_y, q);
+  sycl::free(d_offsets, q);
+  sycl::free(d_axpy_sums, q);
+}
+
+TEST(Scan, CallerWorkspace) {
+  size_t n = 100'000;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+  syclalgo::PoolStats stats = syclalgo::get_pool_stats(q);
+
+  std::vector<int> data(n);
+  std::iota(data.begin(), data.end(), 1);
+
+  std::vector<int> exclusive(n);
+  std::exclusive_scan(data.begin(), data.end(), exclusive.begin(), 0);
+
+  std::vector<int> inclusive(n);
+  std::inclusive_scan(data.begin(), data.end(), inclusive.begin());
+
+  int *d_data = sycl::malloc_device<int>(n, q);
+  q.copy(data.data(), d_data, n);
+
+  int *d_result = sycl::malloc_device<int>(n, q);
+
+  size_t workspace_size = std::max({
+      syclalgo::scan_workspace_size(q, n),
+      syclalgo::recursive_scan_workspace_size(q, n),
+      syclalgo::stream_scan_workspace_size(q, n),
+      syclalgo::spwdlb_scan_workspace_size(q, n),
+  });
+  void *d_workspace = sycl::malloc_device(workspace_size, q);
+
+  std::vector<int> result(n);
+  auto check = [&](const std::vector<int> &scan) {
+    q.copy(d_result, result.data(), n).wait();
+    EXPECT_EQ(scan, result);
+  };
+
+  {
+    SCOPED_TRACE("exclusive_scan");
+    syclalgo::exclusive_scan(q, n, d_data, d_result, d_workspace);
+    check(exclusive);
+  }
+  {
+    SCOPED_TRACE("inclusive_scan");
+    syclalgo::inclusive_scan(q, n, d_data, d_result, d_workspace);
+    check(inclusive);
+  }
+  {
+    SCOPED_TRACE("exclusive_recursive_scan");
+    syclalgo::exclusive_recursive_scan(q, n, d_data, d_result, d_workspace);
+    check(exclusive);
+  }
+  {
+    SCOPED_TRACE("inclusive_stream_scan");
+    syclalgo::inclusive_stream_scan(q, n, d_data, d_result, d_workspace);
+    check(inclusive);
+  }
+  {
+    SCOPED_TRACE("exclusive_spwdlb_scan");
+    syclalgo::exclusive_spwdlb_scan(q, n, d_data, d_result, d_workspace);
+    check(exclusive);
+  }
+
+  syclalgo::PoolStats end_stats = syclalgo::get_pool_stats(q);
+  EXPECT_EQ(end_stats.num_device_allocations, stats.num_device_allocations);
+  EXPECT_EQ(end_stats.num_cache_hits, stats.num_cache_hits);
+
+  sycl::free(d_workspace, q);
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+}
+
+// Small inputs are scanned by a single work-group, without a workspace.
+TEST(Scan, SmallInputs) {
+  size_t max_n = syclalgo::detail::SINGLE_GROUP_SCAN_MAX_N;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+  syclalgo::PoolStats stats = syclalgo::get_pool_stats(q);
+
+  std::vector<Affine> data(max_n);
+  for (size_t i = 0; i < max_n; ++i) {
+    data[i] = {i % 3 == 0 ? -1 : 1, int64_t(i % 7)};
+  }
+
+  AffineCompose op;
+  Affine identity = {1, 0};
+
+  Affine *d_data = sycl::malloc_device<Affine>(max_n, q);
+  q.copy(data.data(), d_data, max_n);
+
+  Affine *d_result = sycl::malloc_device<Affine>(max_n, q);
+
+  for (size_t n : {size_t(1), size_t(17), size_t(256), size_t(2049), max_n}) {
+    SCOPED_TRACE(n);
+
+    std::vector<Affine> exclusive(n);
+    std::exclusive_scan(data.begin(), data.begin() + n, exclusive.begin(),
+                        identity, op);
+    std::vector<Affine> inclusive(n);
+    std::inclusive_scan(data.begin(), data.begin() + n, inclusive.begin(), op);
+
+    std::vector<Affine> result(n);
+    syclalgo::exclusive_scan(q, n, d_data, d_result, op, identity);
+    q.copy(d_result, result.data(), n).wait();
+    EXPECT_TRUE(exclusive == result);
+
+    syclalgo::inclusive_scan(q, n, d_data, d_result, op, identity);
+    q.copy(d_result, result.data(), n).wait();
+    EXPECT_TRUE(inclusive == result);
+  }
+
+  syclalgo::PoolStats end_stats = syclalgo::get_pool_stats(q);
+  EXPECT_EQ(end_stats.num_device_allocations, stats.num_device_allocations);
+  EXPECT_EQ(end_stats.num_cache_hits, stats.num_cache_hits);
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+}
+
+// Whether the device can run a scan choice, with the checks of syclalgo-tune:
+// scans that wait between work-groups need forward progress, and the tile must
+// fit the work-group and local memory limits.
+template <typename T>
+auto scan_runs(const sycl::device &dev, syclalgo::detail::ScanChoice choice)
+    -> bool {
+  return syclalgo::detail::scan_allowed(syclalgo::detail::get_device_info(dev),
+                                        choice.algorithm) &&
+         syclalgo::detail::scan_fits<T>(dev, choice.algorithm, choice.config);
+}
+
+TEST(Scan, TunedConfigs) {
+  size_t n = 100'000;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::vector<int> data(n);
+  std::iota(data.begin(), data.end(), 1);
+
+  std::vector<int> exclusive(n);
+  std::exclusive_scan(data.begin(), data.end(), exclusive.begin(), 0);
+
+  int *d_data = sycl::malloc_device<int>(n, q);
+  q.copy(data.data(), d_data, n);
+
+  int *d_result = sycl::malloc_device<int>(n, q);
+
+  std::vector<int> result(n);
+  for (auto algorithm : syclalgo::detail::SCAN_ALGORITHMS) {
+    for (auto config : syclalgo::detail::scan_configs(algorithm)) {
+      syclalgo::detail::ScanChoice choice = {algorithm, config};
+      if (!scan_runs<int>(q.get_device(), choice)) {
+        continue;
+      }
+      std::string name(syclalgo::detail::scan_algorithm_name(algorithm));
+      SCOPED_TRACE(name + " " + std::to_string(config.block_size) + "x" +
+                   std::to_string(config.elems) + " " +
+                   std::string(syclalgo::detail::group_scan_algorithm_name(
+                       config.group_scan)));
+      size_t workspace_size =
+          syclalgo::detail::scan_scratch_size<int>(q.get_device(), choice, n);
+      void *d_workspace = sycl::malloc_device(workspace_size, q);
+      syclalgo::detail::scan<syclalgo::detail::ScanType::Exclusive>(
+          q, choice, n, d_data, d_result, sycl::plus<int>(), 0, {0},
+          d_workspace);
+      q.copy(d_result, result.data(), n).wait();
+      EXPECT_EQ(exclusive, result);
+      sycl::free(d_workspace, q);
+    }
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+}
+
+TEST(Scan, BrentKungGroupScan) {
+  using syclalgo::detail::GroupScanAlgorithm;
+
+  size_t n = 100'000;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::vector<Affine> data(n);
+  for (size_t i = 0; i < n; ++i) {
+    data[i] = {i % 3 == 0 ? -1 : 1, int64_t(i % 7)};
+  }
+
+  AffineCompose op;
+  Affine identity = {1, 0};
+
+  std::vector<Affine> inclusive(n);
+  std::inclusive_scan(data.begin(), data.end(), inclusive.begin(), op);
+
+  Affine *d_data = sycl::malloc_device<Affine>(n, q);
+  q.copy(data.data(), d_data, n);
+
+  Affine *d_result = sycl::malloc_device<Affine>(n, q);
+
+  std::vector<Affine> result(n);
+  for (auto algorithm : syclalgo::detail::SCAN_ALGORITHMS) {
+    for (auto config : syclalgo::detail::scan_configs(algorithm)) {
+      syclalgo::detail::ScanChoice choice = {algorithm, config};
+      if (config.group_scan != GroupScanAlgorithm::BrentKung ||
+          !scan_runs<Affine>(q.get_device(), choice)) {
+        continue;
+      }
+      SCOPED_TRACE(syclalgo::detail::scan_algorithm_name(algorithm));
+      size_t workspace_size = syclalgo::detail::scan_scratch_size<Affine>(
+          q.get_device(), choice, n);
+      void *d_workspace = sycl::malloc_device(workspace_size, q);
+      syclalgo::detail::scan<syclalgo::detail::ScanType::Inclusive>(
+          q, choice, n, d_data, d_result, op, identity, {identity},
+          d_workspace);
+      q.copy(d_result, result.data(), n).wait();
+      EXPECT_TRUE(inclusive == result);
+      sycl::free(d_workspace, q);
+    }
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+}
+
+// Scans an input in chunks, each starting from the total of the one before, by
+// every scan the dispatcher can pick.
+TEST(Scan, CarryChaining) {
+  using syclalgo::detail::ScanType;
+
+  size_t n = 30'001;
+  size_t chunk = 10'000;
+  size_t num_chunks = syclalgo::detail::ceil_div(n, chunk);
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::vector<Affine> data(n);
+  for (size_t i = 0; i < n; ++i) {
+    data[i] = {i % 5 == 0 ? -1 : 1, int64_t(i % 11)};
+  }
+
+  AffineCompose op;
+  Affine identity = {1, 0};
+  Affine init = {-1, 3};
+
+  std::vector<Affine> exclusive(n);
+  std::exclusive_scan(data.begin(), data.end(), exclusive.begin(), init, op);
+
+  std::vector<Affine> inclusive(n);
+  std::inclusive_scan(data.begin(), data.end(), inclusive.begin(), op, init);
+
+  Affine *d_data = sycl::malloc_device<Affine>(n, q);
+  q.copy(data.data(), d_data, n);
+
+  Affine *d_result = sycl::malloc_device<Affine>(n, q);
+  Affine *d_totals = sycl::malloc_device<Affine>(num_chunks, q);
+
+  auto chunk_carry = [&](size_t c) -> syclalgo::ScanCarry<Affine> {
+    return {init, c > 0 ? d_totals + c - 1 : nullptr, d_totals + c};
+  };
+
+  std::vector<Affine> result(n);
+  Affine total;
+  for (auto algorithm : syclalgo::detail::SCAN_ALGORITHMS) {
+    syclalgo::detail::ScanChoice choice = {
+        algorithm, syclalgo::detail::scan_configs(algorithm)[0]};
+    if (!scan_runs<Affine>(q.get_device(), choice)) {
+      continue;
+    }
+    SCOPED_TRACE(syclalgo::detail::scan_algorithm_name(algorithm));
+    size_t workspace_size = syclalgo::detail::scan_scratch_size<Affine>(
+        q.get_device(), choice, chunk);
+    void *d_workspace = sycl::malloc_device(workspace_size, q);
+
+    for (size_t c = 0; c < num_chunks; ++c) {
+      size_t offset = c * chunk;
+      syclalgo::detail::scan<ScanType::Exclusive>(
+          q, choice, std::min(chunk, n - offset), d_data + offset,
+          d_result + offset, op, identity, chunk_carry(c), d_workspace);
+    }
+    q.copy(d_result, result.data(), n);
+    q.copy(d_totals + num_chunks - 1, &total, 1).wait();
+    EXPECT_TRUE(exclusive == result);
+    EXPECT_TRUE(op(exclusive[n - 1], data[n - 1]) == total);
+
+    for (size_t c = 0; c < num_chunks; ++c) {
+      size_t offset = c * chunk;
+      syclalgo::detail::scan<ScanType::Inclusive>(
+          q, choice, std::min(chunk, n - offset), d_data + offset,
+          d_result + offset, op, identity, chunk_carry(c), d_workspace);
+    }
+    q.copy(d_result, result.data(), n);
+    q.copy(d_totals + num_chunks - 1, &total, 1).wait();
+    EXPECT_TRUE(inclusive == result);
+    EXPECT_TRUE(inclusive[n - 1] == total);
+
+    sycl::free(d_workspace, q);
+  }
+
+  // An empty chunk passes its carry-in on.
+  syclalgo::exclusive_scan(q, 0, d_data, d_result, op, identity,
+                           chunk_carry(1));
+  q.copy(d_totals + 1, &total, 1).wait();
+  EXPECT_TRUE(inclusive[chunk - 1] == total);
+
+  // A host scalar start on the pool form.
+  syclalgo::inclusive_scan(q, n, d_data, d_result, op, identity,
+                           chunk_carry(0));
+  q.copy(d_result, result.data(), n);
+  q.copy(d_totals, &total, 1).wait();
+  EXPECT_TRUE(inclusive == result);
+  EXPECT_TRUE(inclusive[n - 1] == total);
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+  sycl::free(d_totals, q);
+}
+
+TEST(Scan, HostScan) {
+  size_t n = 100'003;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::vector<int> data(n);
+  std::iota(data.begin(), data.end(), 1);
+
+  std::vector<int> exclusive(n);
+  std::exclusive_scan(data.begin(), data.end(), exclusive.begin(), 0);
+
+  std::vector<int> result(n);
+  for (size_t chunk_elems : {0, 100'003, 30'000, 10'000}) {
+    SCOPED_TRACE(testing::Message() << "chunk_elems = " << chunk_elems);
+    syclalgo::exclusive_host_scan(q, n, data.data(), result.data(),
+                                  chunk_elems);
+    EXPECT_EQ(exclusive, result);
+  }
+
+  // Pinned host memory, with an associative but not commutative op.
+  std::vector<Affine> affine_data(n);
+  for (size_t i = 0; i < n; ++i) {
+    affine_data[i] = {i % 3 == 0 ? -1 : 1, int64_t(i % 7)};
+  }
+
+  AffineCompose op;
+  std::vector<Affine> inclusive(n);
+  std::inclusive_scan(affine_data.begin(), affine_data.end(),
+                      inclusive.begin(), op);
+
+  Affine *h_data = sycl::malloc_host<Affine>(n, q);
+  Affine *h_result = sycl::malloc_host<Affine>(n, q);
+  std::copy(affine_data.begin(), affine_data.end(), h_data);
+
+  syclalgo::inclusive_host_scan(q, n, h_data, h_result, op, Affine{1, 0},
+                                7'000);
+  EXPECT_TRUE(std::equal(inclusive.begin(), inclusive.end(), h_result));
+
+  sycl::free(h_data, q);
+  sycl::free(h_result, q);
+
+  // Two halves chained through a total in device memory.
+  {
+    SCOPED_TRACE("carry");
+    size_t half = n / 2;
+    int *d_total = sycl::malloc_device<int>(1, q);
+    syclalgo::exclusive_host_scan(q, half, data.data(), result.data(),
+                                  sycl::plus<int>(), 0, {0, nullptr, d_total},
+                                  10'000);
+    syclalgo::exclusive_host_scan(q, n - half, data.data() + half,
+                                  result.data() + half, sycl::plus<int>(), 0,
+                                  {0, d_total, nullptr}, 10'000);
+    EXPECT_EQ(exclusive, result);
+    sycl::free(d_total, q);
+  }
+}
+
+// Looks back over many partitions that only published their aggregates, so
+// the look-back has to slide its window several times.
+TEST(Scan, SubGroupLookBack) {
+  using syclalgo::detail::PartitionDescriptors;
+
+  int num_partitions = 100;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::vector<Affine> data(num_partitions);
+  for (int i = 0; i < num_partitions; ++i) {
+    data[i] = {i % 3 == 0 ? -1 : 1, i % 7};
+  }
+
+  AffineCompose op;
+  Affine identity = {1, 0};
+  Affine exclusive =
+      std::accumulate(data.begin(), data.end() - 1, identity, op);
+
+  Affine *d_data = sycl::malloc_device<Affine>(num_partitions, q);
+  q.copy(data.data(), d_data, num_partitions);
+
+  void *d_workspace = sycl::malloc_device(
+      PartitionDescriptors<Affine>::storage_size(num_partitions), q);
+  PartitionDescriptors<Affine> descriptors(d_workspace, num_partitions);
+
+  Affine *d_result = sycl::malloc_device<Affine>(2, q);
+
+  q.parallel_for(sycl::nd_range<1>(64, 64), [=](sycl::nd_item<1> id) {
+    auto sg = id.get_sub_group();
+    int bid = num_partitions - 1;
+    for (int pid = id.get_local_id(); pid < bid; pid += 64) {
+      descriptors.store(pid,
+                        pid == 0 ? syclalgo::detail::PrefixAvailable
+                                 : syclalgo::detail::AggregateAvailable,
+                        d_data[pid]);
+    }
+    sycl::group_barrier(id.get_group());
+
+    if (sg.get_group_linear_id() == 0) {
+      Affine prefix = syclalgo::detail::sub_group_look_back(
+          sg, descriptors, bid, false, d_data[bid], op, identity);
+      if (sg.leader()) {
+        d_result[0] = prefix;
+        d_result[1] = descriptors.load(bid).value;
+      }
+    }
+  });
+
+  Affine result[2];
+  q.copy(d_result, result, 2).wait();
+  EXPECT_EQ(result[0], exclusive);
+  EXPECT_EQ(result[1], op(exclusive, data.back()));
+
+  sycl::free(d_data, q);
+  sycl::free(d_workspace, q);
+  sycl::free(d_result, q);
+}
+
+#ifdef SYCLALGO_LOOK_BACK_STATS
+// Every work-group of the stream and look-back scans adds one count to each of
+// their histograms, and only the first partition has no predecessors.
+TEST(Scan, LookBackStats) {
+  size_t n = 1'000'000;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::vector<int> data(n, 1);
+  int *d_data = sycl::malloc_device<int>(n, q);
+  q.copy(data.data(), d_data, n);
+
+  int *d_result = sycl::malloc_device<int>(n, q);
+
+  syclalgo::take_look_back_stats(q);
+  syclalgo::exclusive_stream_scan(q, n, d_data, d_result);
+  syclalgo::exclusive_spwdlb_scan(q, n, d_data, d_result);
+  syclalgo::LookBackStats stats = syclalgo::take_look_back_stats(q);
+
+  auto num_groups = [](const syclalgo::LookBackHistogram &histogram) {
+    return std::accumulate(histogram.buckets.begin(), histogram.buckets.end(),
+                           size_t(0));
+  };
+  EXPECT_GT(num_groups(stats.stream_spins), 1);
+  EXPECT_GT(num_groups(stats.look_back_spins), 1);
+  EXPECT_EQ(num_groups(stats.look_back_depth),
+            num_groups(stats.look_back_spins));
+  EXPECT_EQ(stats.look_back_depth.buckets[0], 1);
+
+  syclalgo::LookBackStats cleared = syclalgo::take_look_back_stats(q);
+  EXPECT_EQ(num_groups(cleared.stream_spins), 0);
+  EXPECT_EQ(num_groups(cleared.look_back_depth), 0);
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+}
+#endif
+
+TEST(Scan, TuningFile) {
+  using syclalgo::detail::GroupScanAlgorithm;
+  using syclalgo::detail::ScanAlgorithm;
+
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "sycltest-scan-tuning.tsv";
+  std::vector<syclalgo::detail::ScanTuning> tunings = {
+      {"GPU 1", "1.0", 4096, {ScanAlgorithm::Recursive, {128, 8}}},
+      {"GPU 1", "1.0", SIZE_MAX,
+       {ScanAlgorithm::LookBack, {256, 7, GroupScanAlgorithm::BrentKung}}},
+      {"CPU 2", "2.0", SIZE_MAX, {ScanAlgorithm::ReduceThenScan, {64, 0}}},
+  };
+  syclalgo::detail::write_scan_tuning(path, tunings);
+  std::ofstream(path, std::ios::app)
+      << "CPU 3\t3.0\t100\tbogus\t1\t1\n"
+      << "CPU 4\t4.0\tmax\trecursive\t64\t8\n";
+  tunings.push_back(
+      {"CPU 4", "4.0", SIZE_MAX, {ScanAlgorithm::Recursive, {64, 8}}});
+
+  auto read = syclalgo::detail::read_scan_tuning(path);
+  std::filesystem::remove(path);
+
+  ASSERT_EQ(read.size(), tunings.size());
+  for (size_t i = 0; i < read.size(); ++i) {
+    EXPECT_EQ(read[i].device_name, tunings[i].device_name);
+    EXPECT_EQ(read[i].driver_version, tunings[i].driver_version);
+    EXPECT_EQ(read[i].max_n, tunings[i].max_n);
+    EXPECT_EQ(read[i].choice.algorithm, tunings[i].choice.algorithm);
+    EXPECT_EQ(read[i].choice.config, tunings[i].choice.config);
+  }
+
+  EXPECT_TRUE(syclalgo::detail::read_scan_tuning(path).empty());
+}
+
+TEST(Reduce, Reduce) {
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  for (size_t n : {0, 1, 1000, 100'000, 10'000'003}) {
+    SCOPED_TRACE(n);
+
+    std::vector<int> data(n);
+    for (size_t i = 0; i < n; ++i) {
+      data[i] = int((i * 7919) % 1000) - 300;
+    }
+
+    int *d_data = sycl::malloc_device<int>(n + 1, q);
+    q.copy(data.data(), d_data, n);
+
+    int *d_sum = sycl::malloc_device<int>(1, q);
+    int64_t *d_wide_sum = sycl::malloc_device<int64_t>(1, q);
+    int *d_min = sycl::malloc_device<int>(1, q);
+    int64_t *d_squares = sycl::malloc_device<int64_t>(1, q);
+
+    void *d_workspace = sycl::malloc_device(
+        syclalgo::reduce_workspace_size<int64_t>(q, n), q);
+
+    syclalgo::reduce(q, n, d_data, d_sum);
+    syclalgo::reduce(q, n, d_data, d_wide_sum, sycl::plus<int64_t>(),
+                     int64_t(0), d_workspace);
+    syclalgo::reduce(q, n, d_data, d_min, sycl::minimum<int>(),
+                     std::numeric_limits<int>::max());
+    syclalgo::transform_reduce(
+        q, n, d_data, d_squares, sycl::plus<int64_t>(), int64_t(0),
+        [](int x) { return int64_t(x) * x; }, d_workspace);
+
+    int sum = 0;
+    int64_t wide_sum = 0;
+    int min = 0;
+    int64_t squares = 0;
+    q.copy(d_sum, &sum, 1);
+    q.copy(d_wide_sum, &wide_sum, 1);
+    q.copy(d_min, &min, 1);
+    q.copy(d_squares, &squares, 1).wait();
+
+    EXPECT_EQ(std::reduce(data.begin(), data.end()), sum);
+    EXPECT_EQ(std::reduce(data.begin(), data.end(), int64_t(0)), wide_sum);
+    EXPECT_EQ(std::reduce(data.begin(), data.end(),
+                          std::numeric_limits<int>::max(),
+                          [](int a, int b) { return std::min(a, b); }),
+              min);
+    EXPECT_EQ(std::transform_reduce(data.begin(), data.end(), int64_t(0),
+                                    std::plus<int64_t>(),
+                                    [](int x) { return int64_t(x) * x; }),
+              squares);
+
+    sycl::free(d_workspace, q);
+    sycl::free(d_data, q);
+    sycl::free(d_sum, q);
+    sycl::free(d_wide_sum, q);
+    sycl::free(d_min, q);
+    sycl::free(d_squares, q);
+  }
+}
+
+TEST(Reduce, ArgMinMax) {
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  for (size_t n : {0, 1, 100'000}) {
+    SCOPED_TRACE(n);
+
+    // Every value repeats, so the first extreme element must win.
+    std::vector<float> data(n);
+    for (size_t i = 0; i < n; ++i) {
+      data[i] = float((i * 7919) % 1000) - 300;
+    }
+
+    float *d_data = sycl::malloc_device<float>(n + 1, q);
+    q.copy(data.data(), d_data, n);
+    size_t *d_indices = sycl::malloc_device<size_t>(2, q);
+
+    void *d_workspace = sycl::malloc_device(
+        syclalgo::arg_reduce_workspace_size<float>(q, n), q);
+
+    syclalgo::argmin(q, n, d_data, d_indices);
+    syclalgo::argmax(q, n, d_data, d_indices + 1, d_workspace);
+
+    size_t indices[2];
+    q.copy(d_indices, indices, 2).wait();
+
+    EXPECT_EQ(size_t(std::min_element(data.begin(), data.end()) - data.begin()),
+              indices[0]);
+    EXPECT_EQ(size_t(std::max_element(data.begin(), data.end()) - data.begin()),
+              indices[1]);
+
+    sycl::free(d_workspace, q);
+    sycl::free(d_data, q);
+    sycl::free(d_indices, q);
+  }
+}
+
+// Reductions from the pool share a workspace whose counter the last
+// work-group of each call leaves zeroed for the next.
+TEST(Reduce, ReusedWorkspace) {
+  size_t n = 100'000;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::vector<int> data(n);
+  for (size_t i = 0; i < n; ++i) {
+    data[i] = int((i * 7919) % 1000) - 300;
+  }
+
+  int *d_data = sycl::malloc_device<int>(n, q);
+  q.copy(data.data(), d_data, n);
+  int64_t *d_sums = sycl::malloc_device<int64_t>(10, q);
+  size_t *d_indices = sycl::malloc_device<size_t>(10, q);
+
+  syclalgo::reduce(q, n, d_data, d_sums, sycl::plus<int64_t>(), int64_t(0));
+  syclalgo::argmin(q, n, d_data, d_indices).wait();
+  syclalgo::PoolStats stats = syclalgo::get_pool_stats(q);
+
+  for (size_t i = 1; i < 10; ++i) {
+    syclalgo::reduce(q, n - i, d_data, d_sums + i, sycl::plus<int64_t>(),
+                     int64_t(0));
+    syclalgo::argmin(q, n - i, d_data, d_indices + i);
+  }
+
+  int64_t sums[10];
+  size_t indices[10];
+  q.copy(d_sums, sums, 10);
+  q.copy(d_indices, indices, 10).wait();
+
+  EXPECT_EQ(syclalgo::get_pool_stats(q).num_device_allocations,
+            stats.num_device_allocations);
+  for (size_t i = 0; i < 10; ++i) {
+    SCOPED_TRACE(i);
+    auto last = data.end() - i;
+    EXPECT_EQ(std::reduce(data.begin(), last, int64_t(0)), sums[i]);
+    EXPECT_EQ(size_t(std::min_element(data.begin(), last) - data.begin()),
+              indices[i]);
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_sums, q);
+  sycl::free(d_indices, q);
+}
+
+TEST(Select, CopyIf) {
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  auto is_odd = [](int v) { return v % 2 != 0; };
+
+  for (size_t n : {0, 1, 1000, 100'000}) {
+    SCOPED_TRACE(n);
+
+    std::vector<int> data(n);
+    for (size_t i = 0; i < n; ++i) {
+      data[i] = (i * 7919) % 1000;
+    }
+
+    std::vector<int> selected;
+    std::copy_if(data.begin(), data.end(), std::back_inserter(selected),
+                 is_odd);
+    std::vector<int> kept;
+    std::remove_copy_if(data.begin(), data.end(), std::back_inserter(kept),
+                        is_odd);
+
+    int *d_data = sycl::malloc_device<int>(n + 1, q);
+    q.copy(data.data(), d_data, n);
+    int *d_result = sycl::malloc_device<int>(n + 1, q);
+    size_t *d_count = sycl::malloc_device<size_t>(1, q);
+
+    void *d_workspace =
+        sycl::malloc_device(syclalgo::select_workspace_size(q, n), q);
+
+    size_t count = 0;
+    std::vector<int> result(n);
+    auto check = [&](const std::vector<int> &expected) {
+      q.copy(d_count, &count, 1);
+      q.copy(d_result, result.data(), n).wait();
+      ASSERT_EQ(expected.size(), count);
+      result.resize(count);
+      EXPECT_EQ(expected, result);
+      result.resize(n);
+    };
+
+    {
+      SCOPED_TRACE("copy_if");
+      syclalgo::copy_if(q, n, d_data, d_result, is_odd, d_count);
+      check(selected);
+    }
+    {
+      SCOPED_TRACE("remove_if");
+      syclalgo::remove_if(q, n, d_data, d_result, is_odd, d_count,
+                          d_workspace);
+      check(kept);
+    }
+    {
+      SCOPED_TRACE("count_if");
+      syclalgo::count_if(q, n, d_data, is_odd, d_count, d_workspace);
+      q.copy(d_count, &count, 1).wait();
+      EXPECT_EQ(selected.size(), count);
+      syclalgo::count_if(q, n, d_data, is_odd, d_count);
+      q.copy(d_count, &count, 1).wait();
+      EXPECT_EQ(selected.size(), count);
+    }
+
+    sycl::free(d_workspace, q);
+    sycl::free(d_data, q);
+    sycl::free(d_result, q);
+    sycl::free(d_count, q);
+  }
+}
+
+TEST(Select, Partition) {
+  size_t n = 100'000;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  // Pairs of key and position check that both sides keep the input order.
+  std::vector<std::array<int, 2>> data(n);
+  for (size_t i = 0; i < n; ++i) {
+    data[i] = {int((i * 7919) % 1000), int(i)};
+  }
+
+  auto is_small = [](const std::array<int, 2> &v) { return v[0] < 300; };
+  std::vector<std::array<int, 2>> partitioned = data;
+  auto middle = std::stable_partition(partitioned.begin(), partitioned.end(),
+                                      is_small);
+
+  auto *d_data = sycl::malloc_device<std::array<int, 2>>(n, q);
+  q.copy(data.data(), d_data, n);
+  auto *d_selected = sycl::malloc_device<std::array<int, 2>>(n, q);
+  auto *d_rejected = sycl::malloc_device<std::array<int, 2>>(n, q);
+  size_t *d_count = sycl::malloc_device<size_t>(1, q);
+
+  syclalgo::partition(q, n, d_data, d_selected, d_rejected, is_small, d_count);
+
+  size_t count = 0;
+  q.copy(d_count, &count, 1).wait();
+  ASSERT_EQ(size_t(middle - partitioned.begin()), count);
+
+  std::vector<std::array<int, 2>> result(n);
+  q.copy(d_selected, result.data(), count);
+  q.copy(d_rejected, result.data() + count, n - count).wait();
+  EXPECT_EQ(partitioned, result);
+
+  sycl::free(d_data, q);
+  sycl::free(d_selected, q);
+  sycl::free(d_rejected, q);
+  sycl::free(d_count, q);
+}
+
+// Elements too wide to stage a block of them in local memory are written
+// straight to the outputs.
+TEST(Select, WideElements) {
+  size_t n = 20'000;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  using Wide = std::array<int64_t, 64>;
+  std::vector<Wide> data(n);
+  for (size_t i = 0; i < n; ++i) {
+    data[i].fill(int64_t(i));
+    data[i][0] = int64_t((i * 7919) % 1000);
+  }
+
+  auto is_small = [](const Wide &v) { return v[0] < 300; };
+  std::vector<Wide> partitioned = data;
+  auto middle = std::stable_partition(partitioned.begin(), partitioned.end(),
+                                      is_small);
+
+  auto *d_data = sycl::malloc_device<Wide>(n, q);
+  q.copy(data.data(), d_data, n);
+  auto *d_selected = sycl::malloc_device<Wide>(n, q);
+  auto *d_rejected = sycl::malloc_device<Wide>(n, q);
+  size_t *d_count = sycl::malloc_device<size_t>(1, q);
+
+  syclalgo::partition(q, n, d_data, d_selected, d_rejected, is_small, d_count);
+
+  size_t count = 0;
+  q.copy(d_count, &count, 1).wait();
+  ASSERT_EQ(size_t(middle - partitioned.begin()), count);
+
+  std::vector<Wide> result(n);
+  q.copy(d_selected, result.data(), count);
+  q.copy(d_rejected, result.data() + count, n - count).wait();
+  EXPECT_EQ(partitioned, result);
+
+  sycl::free(d_data, q);
+  sycl::free(d_selected, q);
+  sycl::free(d_rejected, q);
+  sycl::free(d_count, q);
+}
+
+template <typename K> void test_radix_sort_keys(const std::vector<K> &keys) {
+  size_t n = keys.size();
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::vector<K> sorted = keys;
+  std::sort(sorted.begin(), sorted.end());
+
+  K *d_keys = sycl::malloc_device<K>(n + 1, q);
+  q.copy(keys.data(), d_keys, n);
+  K *d_result = sycl::malloc_device<K>(n + 1, q);
+
+  std::vector<K> result(n);
+  syclalgo::radix_sort_keys(q, n, d_keys, d_result);
+  q.copy(d_result, result.data(), n).wait();
+  EXPECT_EQ(sorted, result);
+
+  // In place, with a caller workspace.
+  void *d_workspace = sycl::malloc_device(
+      syclalgo::radix_sort_keys_workspace_size<K>(q, n), q);
+  syclalgo::radix_sort_keys(q, n, d_keys, d_keys, d_workspace);
+  q.copy(d_keys, result.data(), n).wait();
+  EXPECT_EQ(sorted, result);
+
+  sycl::free(d_workspace, q);
+  sycl::free(d_keys, q);
+  sycl::free(d_result, q);
+}
+
+TEST(Sort, RadixSortKeys) {
+  for (size_t n : {0, 1, 1000, 30'000}) {
+    SCOPED_TRACE(n);
+
+    std::vector<uint32_t> u32(n);
+    std::vector<int> i32(n);
+    std::vector<float> f32(n);
+    std::vector<int64_t> i64(n);
+    std::vector<double> f64(n);
+    for (size_t i = 0; i < n; ++i) {
+      uint32_t r = i * 2654435761u;
+      u32[i] = r;
+      i32[i] = int(r);
+      f32[i] = (int(r % 20'000) - 10'000) / 8.0f;
+      i64[i] = int64_t(r) * (i % 2 ? -65'537 : 65'537);
+      f64[i] = -f32[i] * 1e200;
+    }
+
+    {
+      SCOPED_TRACE("uint32_t");
+      test_radix_sort_keys(u32);
+    }
+    {
+      SCOPED_TRACE("int");
+      test_radix_sort_keys(i32);
+    }
+    {
+      SCOPED_TRACE("float");
+      test_radix_sort_keys(f32);
+    }
+    {
+      SCOPED_TRACE("int64_t");
+      test_radix_sort_keys(i64);
+    }
+    {
+      SCOPED_TRACE("double");
+      test_radix_sort_keys(f64);
+    }
+  }
+}
+
+TEST(Sort, RadixSortPairs) {
+  size_t n = 100'000;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  // Few distinct keys, with their positions as values, check stability.
+  std::vector<int> keys(n);
+  std::vector<uint32_t> values(n);
+  for (size_t i = 0; i < n; ++i) {
+    keys[i] = int((i * 7919) % 1000) - 500;
+    values[i] = i;
+  }
+
+  std::vector<std::pair<int, uint32_t>> pairs(n);
+  for (size_t i = 0; i < n; ++i) {
+    pairs[i] = {keys[i], values[i]};
+  }
+  std::stable_sort(pairs.begin(), pairs.end(),
+                   [](auto a, auto b) { return a.first < b.first; });
+
+  int *d_keys = sycl::malloc_device<int>(n, q);
+  q.copy(keys.data(), d_keys, n);
+  uint32_t *d_values = sycl::malloc_device<uint32_t>(n, q);
+  q.copy(values.data(), d_values, n);
+  int *d_keys_out = sycl::malloc_device<int>(n, q);
+  uint32_t *d_values_out = sycl::malloc_device<uint32_t>(n, q);
+
+  syclalgo::radix_sort_pairs(q, n, d_keys, d_keys_out, d_values,
+                             d_values_out);
+
+  std::vector<int> keys_result(n);
+  std::vector<uint32_t> values_result(n);
+  q.copy(d_keys_out, keys_result.data(), n);
+  q.copy(d_values_out, values_result.data(), n).wait();
+
+  std::vector<std::pair<int, uint32_t>> result(n);
+  for (size_t i = 0; i < n; ++i) {
+    result[i] = {keys_result[i], values_result[i]};
+  }
+  EXPECT_EQ(pairs, result);
+
+  sycl::free(d_keys, q);
+  sycl::free(d_values, q);
+  sycl::free(d_keys_out, q);
+  sycl::free(d_values_out, q);
+}
+
+TEST(Pool, Reuse) {
+  size_t n = 100'000;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::vector<int> data(n);
+  std::iota(data.begin(), data.end(), 1);
+
+  std::vector<int> scan(n);
+  std::exclusive_scan(data.begin(), data.end(), scan.begin(), 0);
+
+  int *d_data = sycl::malloc_device<int>(n, q);
+  q.copy(data.data(), d_data, n);
+
+  int *d_result = sycl::malloc_device<int>(n, q);
+
+  // Other tests may have left blocks with the pool that queues on the same
+  // device and context share.
+  syclalgo::PoolStats first_stats = syclalgo::get_pool_stats(q);
+  syclalgo::exclusive_spwdlb_scan(q, n, d_data, d_result).wait();
+
+  syclalgo::PoolStats stats = syclalgo::get_pool_stats(q);
+  EXPECT_EQ(stats.bytes_in_use, 0);
+  EXPECT_GT(stats.bytes_cached, 0);
+  size_t num_blocks =
+      stats.num_device_allocations - first_stats.num_device_allocations +
+      stats.num_cache_hits - first_stats.num_cache_hits;
+
+  for (int i = 0; i < 10; ++i) {
+    syclalgo::exclusive_spwdlb_scan(q, n, d_data, d_result);
+  }
+
+  std::vector<int> result(n);
+  q.copy(d_result, result.data(), n).wait();
+
+  syclalgo::PoolStats reuse_stats = syclalgo::get_pool_stats(q);
+  EXPECT_EQ(reuse_stats.num_device_allocations, stats.num_device_allocations);
+  EXPECT_EQ(reuse_stats.bytes_high_water, stats.bytes_high_water);
+  EXPECT_EQ(reuse_stats.num_cache_hits, stats.num_cache_hits + 10 * num_blocks);
+
+  syclalgo::trim_pool(q);
+  EXPECT_EQ(syclalgo::get_pool_stats(q).bytes_cached, 0);
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+
+  EXPECT_EQ(scan, result);
+}
+
+// Queues made per call share their pool instead of each keeping blocks alive.
+TEST(Pool, SharedAcrossQueues) {
+  size_t n = 100'000;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::vector<int> data(n, 1);
+  int *d_data = sycl::malloc_device<int>(n, q);
+  q.copy(data.data(), d_data, n);
+
+  int *d_result = sycl::malloc_device<int>(n, q);
+
+  syclalgo::exclusive_spwdlb_scan(q, n, d_data, d_result).wait();
+  syclalgo::PoolStats stats = syclalgo::get_pool_stats(q);
+
+  for (int i = 0; i < 10; ++i) {
+    sycl::queue call_q{q.get_context(), q.get_device(),
+                       sycl::property::queue::in_order()};
+    syclalgo::exclusive_spwdlb_scan(call_q, n, d_data, d_result).wait();
+  }
+
+  EXPECT_EQ(syclalgo::get_pool_stats(q).num_device_allocations,
+            stats.num_device_allocations);
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+}
+
+// Scans that reuse their workspace without clearing it must not see the
+// state of earlier calls, whatever their size and workspace layout.
+TEST(Pool, ReusedWorkspace) {
+  size_t max_n = 300'000;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::vector<int> data(max_n);
+  std::iota(data.begin(), data.end(), 1);
+  std::vector<Affine> affine_data(max_n);
+  for (size_t i = 0; i < max_n; ++i) {
+    affine_data[i] = {i % 3 == 0 ? -1 : 1, int64_t(i % 7)};
+  }
+
+  int *d_data = sycl::malloc_device<int>(max_n, q);
+  q.copy(data.data(), d_data, max_n);
+  Affine *d_affine_data = sycl::malloc_device<Affine>(max_n, q);
+  q.copy(affine_data.data(), d_affine_data, max_n);
+
+  int *d_result = sycl::malloc_device<int>(max_n, q);
+  Affine *d_affine_result = sycl::malloc_device<Affine>(max_n, q);
+
+  AffineCompose op;
+  Affine identity = {1, 0};
+
+  for (size_t n : {100'000, 1'000, 300'000, 100'000, 100'000}) {
+    SCOPED_TRACE(n);
+
+    std::vector<int> exclusive(n);
+    std::exclusive_scan(data.begin(), data.begin() + n, exclusive.begin(), 0);
+    std::vector<Affine> inclusive(n);
+    std::inclusive_scan(affine_data.begin(), affine_data.begin() + n,
+                        inclusive.begin(), op);
+
+    std::vector<int> result(n);
+    syclalgo::exclusive_spwdlb_scan(q, n, d_data, d_result);
+    q.copy(d_result, result.data(), n).wait();
+    EXPECT_EQ(exclusive, result);
+
+    syclalgo::exclusive_stream_scan(q, n, d_data, d_result);
+    q.copy(d_result, result.data(), n).wait();
+    EXPECT_EQ(exclusive, result);
+
+    std::vector<Affine> affine_result(n);
+    syclalgo::inclusive_spwdlb_scan(q, n, d_affine_data, d_affine_result, op,
+                                    identity);
+    q.copy(d_affine_result, affine_result.data(), n).wait();
+    EXPECT_TRUE(inclusive == affine_result);
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_affine_data, q);
+  sycl::free(d_result, q);
+  sycl::free(d_affine_result, q);
+}
+
+// A call with more partitions in the same size class reads statuses where the
+// last call left its int64 values. Tiles summing to 10 leave words that read
+// as published prefixes of the second call on a freshly trimmed pool, and the
+// workspace has to be zeroed before them.
+TEST(Pool, ReusedWorkspaceGrowsWithinBin) {
+  constexpr auto CONFIG = syclalgo::detail::SPWDLB_SCAN_CONFIGS[0];
+  size_t tile_elems = size_t(CONFIG.block_size) * CONFIG.elems;
+  size_t small_n = 60 * tile_elems;
+  size_t large_n = 100 * tile_elems;
+  ASSERT_EQ(
+      std::bit_width(
+          syclalgo::detail::spwdlb_scan_scratch_size<int64_t>(small_n) - 1),
+      std::bit_width(
+          syclalgo::detail::spwdlb_scan_scratch_size<int64_t>(large_n) - 1));
+
+  sycl::queue q{sycl::property::queue::in_order()};
+  syclalgo::trim_pool(q);
+
+  std::vector<int64_t> data(large_n);
+  for (size_t i = 0; i < large_n; ++i) {
+    data[i] = i % tile_elems == 0 ? 10 : 0;
+  }
+
+  int64_t *d_data = sycl::malloc_device<int64_t>(large_n, q);
+  q.copy(data.data(), d_data, large_n);
+
+  int64_t *d_result = sycl::malloc_device<int64_t>(large_n, q);
+
+  for (size_t n : {small_n, large_n}) {
+    SCOPED_TRACE(n);
+
+    std::vector<int64_t> exclusive(n);
+    std::exclusive_scan(data.begin(), data.begin() + n, exclusive.begin(),
+                        int64_t(0));
+
+    std::vector<int64_t> result(n);
+    syclalgo::exclusive_spwdlb_scan(q, n, d_data, d_result,
+                                    sycl::plus<int64_t>(), int64_t(0));
+    q.copy(d_result, result.data(), n).wait();
+    EXPECT_EQ(exclusive, result);
+  }
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+}
+
+TEST(Profile, KernelRecords) {
+  size_t n = 100'000;
+
+  sycl::queue q{sycl::property::queue::in_order(),
+                sycl::property::queue::enable_profiling()};
+
+  std::vector<int> data(n, 1);
+  int *d_data = sycl::malloc_device<int>(n, q);
+  q.copy(data.data(), d_data, n);
+
+  int *d_result = sycl::malloc_device<int>(n, q);
+
+  syclalgo::exclusive_recursive_scan(q, n, d_data, d_result);
+  syclalgo::exclusive_spwdlb_scan(q, n, d_data, d_result);
+
+  std::vector<syclalgo::KernelRecord> records =
+      syclalgo::take_kernel_records(q);
+  EXPECT_TRUE(syclalgo::take_kernel_records(q).empty());
+
+  // The recursive scan sweeps up through its levels and back down.
+  ASSERT_GE(records.size(), 5);
+  EXPECT_EQ(records[0].kernel, "recursive upsweep");
+  EXPECT_EQ(records[0].level, 0);
+  EXPECT_EQ(records[0].n, n);
+  EXPECT_EQ(records[1].kernel, "recursive upsweep");
+  EXPECT_EQ(records[1].level, 1);
+  EXPECT_LT(records[1].n, n);
+  auto downsweep = std::find_if(records.begin(), records.end(),
+                                [](const syclalgo::KernelRecord &r) {
+                                  return r.kernel == "recursive downsweep" &&
+                                         r.level == 0;
+                                });
+  ASSERT_NE(downsweep, records.end());
+  EXPECT_EQ(downsweep->n, n);
+  EXPECT_EQ(records.back().kernel, "look-back scan");
+  EXPECT_EQ(records.back().n, n);
+
+  for (const syclalgo::KernelRecord &r : records) {
+    EXPECT_GT(r.bytes, 0);
+    EXPECT_LE(r.submit_ns, r.start_ns);
+    EXPECT_LE(r.start_ns, r.end_ns);
+  }
+
+  std::ostringstream trace;
+  syclalgo::write_chrome_trace(trace, records);
+  EXPECT_EQ(trace.str().rfind(R"({"traceEvents":[)", 0), 0);
+  EXPECT_NE(trace.str().find(R"("name":"look-back scan")"),
+            std::string::npos);
+
+  // Queues without profiling record nothing.
+  sycl::queue plain_q{sycl::property::queue::in_order()};
+  syclalgo::exclusive_recursive_scan(plain_q, n, d_data, d_result).wait();
+  EXPECT_TRUE(syclalgo::take_kernel_records(plain_q).empty());
+
+  sycl::free(d_data, q);
+  sycl::free(d_result, q);
+}
+
+// The algorithms run on host and shared allocations in place, without copies
+// to and from device memory.
+TEST(ZeroCopy, HostAndSharedMemory) {
+  size_t n = 100'003;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+
+  std::vector<int> data(n);
+  std::iota(data.begin(), data.end(), 1);
+
+  std::vector<int> exclusive(n);
+  std::exclusive_scan(data.begin(), data.end(), exclusive.begin(), 0);
+
+  std::vector<float> y(n);
+  std::transform(data.begin(), data.end(), y.begin(),
+                 [](int x) { return 2.0f * x + 1.0f; });
+
+  for (auto kind : {sycl::usm::alloc::host, sycl::usm::alloc::shared}) {
+    SCOPED_TRACE(kind == sycl::usm::alloc::host ? "host" : "shared");
+
+    int *h_data = sycl::malloc<int>(n, q, kind);
+    int *h_result = sycl::malloc<int>(n, q, kind);
+    std::copy(data.begin(), data.end(), h_data);
+
+    syclalgo::exclusive_scan(q, n, h_data, h_result).wait();
+    EXPECT_TRUE(std::equal(exclusive.begin(), exclusive.end(), h_result));
+
+    float *h_x = sycl::malloc<float>(n, q, kind);
+    float *h_y = sycl::malloc<float>(n, q, kind);
+    std::copy(data.begin(), data.end(), h_x);
+    std::fill(h_y, h_y + n, 1.0f);
+
+    syclalgo::saxpy(q, n, 2.0f, h_x, h_y).wait();
+    EXPECT_TRUE(std::equal(y.begin(), y.end(), h_y));
+
+    sycl::free(h_data, q);
+    sycl::free(h_result, q);
+    sycl::free(h_x, q);
+    sycl::free(h_y, q);
+  }
+}
+
+// Devices that access system allocations scan memory-mapped files in place.
+TEST(ZeroCopy, MappedFile) {
+  size_t n = 100'003;
+  size_t bytes = sizeof(int) * n;
+
+  sycl::queue q{sycl::property::queue::in_order()};
+  if (!q.get_device().has(sycl::aspect::usm_system_allocations)) {
+    GTEST_SKIP() << "device does not access system allocations";
+  }
+
+  std::vector<int> data(n);
+  std::iota(data.begin(), data.end(), 1);
+
+  std::vector<int> exclusive(n);
+  std::exclusive_scan(data.begin(), data.end(), exclusive.begin(), 0);
+
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "sycltest-zero-copy.bin";
+  {
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(data.data()), bytes);
+  }
+
+  int fd = open(path.c_str(), O_RDONLY);
+  ASSERT_GE(fd, 0);
+  void *mapped = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  ASSERT_NE(mapped, MAP_FAILED);
+
+  // Read from the mapping and written to plain host memory.
+  std::vector<int> result(n);
+  syclalgo::exclusive_scan(q, n, static_cast<const int *>(mapped),
+                           result.data())
+      .wait();
+  EXPECT_EQ(exclusive, result);
+
+  munmap(mapped, bytes);
+  std::filesystem::remove(path);
+}
+
 } // namespace